@@ -10,6 +10,7 @@
 #include <CL/cl.hpp>
 
 #include "mC.h"
+#include "programcache.h"
 
 /**
  * Retrieves the directory name of the current _Linux_ executable.
@@ -84,7 +85,7 @@ void calculate_mC_rows(
 		std::cerr << mpiRank << ": Failed to create OpenCL command queue with error " << err << std::endl;
 	}
 
-	// Build OpenCL program.
+	// Build OpenCL program, or load its binary cached by a previous build.
 	std::string clSourcePath = getExecutablePath().append("/mC.opencl.cl");
 	std::fstream clSourceFile;
 	clSourceFile.open(clSourcePath);
@@ -97,7 +98,7 @@ void calculate_mC_rows(
 	clSourceStream << clSourceFile.rdbuf();
 	std::string clSource = clSourceStream.str();
 
-	cl::Program program(ctx, clSource, true, &err);
+	cl::Program program = buildProgram(ctx, device, clSource, clSourcePath, &err);
 	if (err != CL_SUCCESS && mpiRank == 0)
 	{
 		std::cerr << ": Failed to build OpenCL program with error " << err << std::endl;
@@ -0,0 +1,24 @@
+#ifdef MULTIPLY_MODE_OPENCL
+
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <string>
+#include <CL/cl.hpp>
+
+/**
+ * Builds the OpenCL program of `source` for `device`, reusing the program binary cached on disk by a previous build (if
+ * any) rather than compiling the source.
+ *
+ * Binaries are cached next to `sourcePath`, keyed by the name & driver version of `device` and a hash of `source`, such
+ * that they're rebuilt whenever any of those change. If the cached binary fails to load, or nothing is cached, the
+ * program is built from source & its binary cached for subsequent builds. `err` receives the result of the build.
+ */
+cl::Program buildProgram(
+	const cl::Context& ctx, const cl::Device& device, const std::string& source, const std::string& sourcePath,
+	cl_int* err
+);
+
+#endif
+
+#endif
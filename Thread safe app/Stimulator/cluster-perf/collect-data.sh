@@ -30,18 +30,20 @@ make all-modes
 # Measure
 
 for n in "${N[@]}"; do
-	e=$(bin/cluster-serial -k $k -i perf/$n/values)
-	x=$(echo $e | rev | cut -d' ' -f 1,2 | rev | awk '{ gsub(/[^0-9.]/, ""); print }')
+	for m in serial openmp ; do
+		e=$(bin/cluster-$m -k $k -i perf/$n/values)
+		x=$(echo $e | rev | cut -d' ' -f 1,2 | rev | awk '{ gsub(/[^0-9.]/, ""); print }')
 
-	mkdir -p perf/serial
-	echo $x > perf/serial/$n
-	echo Wrote: perf/serial/$n
+		mkdir -p perf/$m
+		echo $x > perf/$m/$n
+		echo Wrote: perf/$m/$n
+	done
 done
 
 for p in "${P[@]}"; do
 	for n in "${N[@]}"; do
 
-		for m in mpi_serial mpi_opencl ; do
+		for m in mpi_serial mpi_openmp mpi_opencl ; do
 			e=$(mpiexec -n $p bin/cluster-$m -k $k -i perf/$n/values)
 			x=$(echo $e | rev | cut -d' ' -f 1,2 | rev | awk '{ gsub(/[^0-9.]/, ""); print }')
 
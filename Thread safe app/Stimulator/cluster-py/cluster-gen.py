@@ -1,4 +1,5 @@
 import os
+import struct
 from argparse import ArgumentParser
 from sklearn.datasets import make_blobs
 
@@ -14,10 +15,18 @@ if __name__ == '__main__':
 		'-k', metavar='K', type=int, required=False,
 		help='Number of centroids.',
 	)
+	parser.add_argument(
+		'-d', metavar='D', type=int, required=False, default=1,
+		help='Number of dimensions of each value.',
+	)
 	parser.add_argument(
 		'-o', metavar='OUTPUT', required=True,
 		help='Directory to which the ouptut must be produced.',
 	)
+	parser.add_argument(
+		'-b', required=False, action='store_true',
+		help='Also outputs values in the binary format of the cluster program (values.bin).',
+	)
 	parser.add_argument(
 		'-g', required=False, action='store_true',
 		help='Outputs a .gitignore file that excludes everything in the output directory.',
@@ -27,12 +36,15 @@ if __name__ == '__main__':
 	# Make blobs
 	x, y, centroids = make_blobs(
 		n_samples=args.n, centers=args.k,
-		n_features=1, return_centers=True, center_box=(0, 100),
+		n_features=args.d, return_centers=True, center_box=(0, 100),
 	)
 
-	# Convert [[a], [b]] to [a, b] (n_features=1)
-	x = [x for [x] in x]
-	centroids = [c for [c] in centroids]
+	# Binary: magic, d (u32), value size (u32), n (u64), followed by each feature of all values as little-endian doubles
+	binary = b'CLUSTBIN' + struct.pack('<IIQ', args.d, 8, args.n) + x.T.astype('<f8').tobytes()
+
+	# Convert [[a, b], [c, d]] to ['a b', 'c d'] (one value per line, one column per feature)
+	x = [' '.join(map(str, x)) for x in x]
+	centroids = [' '.join(map(str, c)) for c in centroids]
 
 	# Output
 	def write(path, contents):
@@ -44,4 +56,8 @@ if __name__ == '__main__':
 	write(f'{args.o}/values', [str(x) + '\n' for x in x])
 	write(f'{args.o}/memberships_o', [str(y) + '\n' for y in y])
 	write(f'{args.o}/centroids_o', [str(c) + '\n' for c in centroids])
+	if args.b:
+		print(f'Writing {args.o}/values.bin')
+		with open(f'{args.o}/values.bin', 'wb') as f:
+			f.write(binary)
 	if args.g: write(f'{args.o}/.gitignore', ['*\n', ''])
@@ -0,0 +1,429 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <vector>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/loader.h"
+#include "../src/timings.h"
+
+/**
+ * Represents CLI arguments passed to the benchmark.
+ */
+struct BenchArgs
+{
+	/**
+	 * Whether any errors occured during argument parsing.
+	 */
+	bool hasError = false;
+
+	/**
+	 * Numbers of points of the generated datasets.
+	 */
+	std::vector<int> sizes = { 100000, 1000000 };
+
+	/**
+	 * Number of dimensions of each point of the generated datasets.
+	 */
+	int d = 2;
+
+	/**
+	 * Number of clusters the points of the generated datasets are drawn from, and computed.
+	 */
+	int k = 5;
+
+	/**
+	 * Numbers of processes the MPI builds are run with.
+	 */
+	std::vector<int> processes = { 2, 4 };
+
+	/**
+	 * Builds that are run, by the suffix of their binary (`cluster-MODE`).
+	 */
+	std::vector<std::string> modes = { "serial", "openmp", "mpi_serial", "mpi_openmp", "mpi_opencl" };
+
+	/**
+	 * Number of runs of each configuration before those that are measured, e.g. to warm the page cache.
+	 */
+	int warmups = 1;
+
+	/**
+	 * Number of measured runs of each configuration.
+	 */
+	int repetitions = 5;
+
+	/**
+	 * Algorithm passed to each run.
+	 */
+	const char* algorithm = "lloyd";
+
+	/**
+	 * Directory containing the binaries of each build.
+	 */
+	const char* binDir = "./bin";
+
+	/**
+	 * Directory to which datasets & the outputs of each run are written.
+	 */
+	const char* dataDir = "./bench/data";
+
+	/**
+	 * File to which statistics are written; `nullptr` for standard output.
+	 */
+	const char* outputFile = nullptr;
+
+	/**
+	 * Shows a help message.
+	 */
+	bool showHelp = false;
+};
+
+/**
+ * Parses the comma-separated list `list` into `values`, returning whether every element is a positive integer.
+ */
+bool parseList(const char* list, std::vector<int>& values)
+{
+	values.clear();
+
+	std::stringstream ss(list);
+	std::string item;
+	while (std::getline(ss, item, ','))
+	{
+		int value = atoi(item.c_str());
+		if (value <= 0)
+			return false;
+
+		values.push_back(value);
+	}
+
+	return !values.empty();
+}
+
+/**
+ * Parses the comma-separated list `list` into `values`, returning whether every element is non-empty.
+ */
+bool parseList(const char* list, std::vector<std::string>& values)
+{
+	values.clear();
+
+	std::stringstream ss(list);
+	std::string item;
+	while (std::getline(ss, item, ','))
+	{
+		if (item.empty())
+			return false;
+
+		values.push_back(item);
+	}
+
+	return !values.empty();
+}
+
+/**
+ * Parses the specified CLI arguments; writes argument-related errors to `std::cerr`.
+ */
+BenchArgs parseBenchArgs(int argc, char** argv)
+{
+	BenchArgs a;
+
+	int c;
+	while ((c = getopt(argc, argv, "n:d:k:P:M:w:r:a:b:D:o:h")) != -1)
+	{
+		switch (c)
+		{
+			case 'n':
+			{
+				if (!parseList(optarg, a.sizes))
+				{
+					std::cerr << "Sizes must be a comma-separated list of positive integers." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case 'P':
+			{
+				if (!parseList(optarg, a.processes))
+				{
+					std::cerr << "Processes must be a comma-separated list of positive integers." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case 'M':
+			{
+				if (!parseList(optarg, a.modes))
+				{
+					std::cerr << "Modes must be a comma-separated list of build names." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case 'd': { a.d = atoi(optarg); break; }
+			case 'k': { a.k = atoi(optarg); break; }
+			case 'w': { a.warmups = atoi(optarg); break; }
+			case 'r': { a.repetitions = atoi(optarg); break; }
+			case 'a': { a.algorithm = optarg; break; }
+			case 'b': { a.binDir = optarg; break; }
+			case 'D': { a.dataDir = optarg; break; }
+			case 'o': { a.outputFile = optarg; break; }
+			case 'h': { a.showHelp = true; break; }
+			case '?': { a.hasError = true; break; }
+		}
+	}
+
+	if (a.d <= 0 || a.k <= 0 || a.warmups < 0 || a.repetitions <= 0)
+	{
+		std::cerr << "Dimensions, K & repetitions must be positive, and warmups non-negative." << std::endl;
+		a.hasError = true;
+	}
+
+	return a;
+}
+
+/**
+ * Writes a binary input file (see `BinaryHeader`) of `n` points of `d` dimensions to `path`, drawn from `k` gaussian
+ * clusters with unit standard deviation & centres uniformly distributed in [0, 10k) in each dimension. Datasets are
+ * generated from a fixed seed, such that the same arguments always produce the same file.
+ *
+ * Returns whether the file was written; writes the reason to `std::cerr` otherwise.
+ */
+bool generateDataset(const std::string& path, int n, int d, int k)
+{
+	std::ofstream f(path, std::ios::binary);
+	if (!f.is_open())
+	{
+		std::cerr << "Failed to open " << path << " for writing values." << std::endl;
+		return false;
+	}
+
+	BinaryHeader header = {};
+	memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	header.d = d;
+	header.valueSize = sizeof(double);
+	header.n = n;
+	f.write((const char*)&header, sizeof(header));
+
+	std::mt19937_64 rng(n);
+	std::uniform_real_distribution<double> centre(0, 10.0 * k);
+	std::normal_distribution<double> offset(0, 1);
+
+	std::vector<double> centres(k * d);
+	for (double& c : centres)
+		c = centre(rng);
+
+	// Values are stored as a structure of arrays, so are generated a dimension at a time; points are assigned to
+	// clusters round-robin.
+	std::vector<double> values(n);
+	for (int j = 0; j < d; j++)
+	{
+		for (int i = 0; i < n; i++)
+			values[i] = centres[(i % k) * d + j] + offset(rng);
+
+		f.write((const char*)values.data(), sizeof(double) * n);
+	}
+
+	f.close();
+	return f.good();
+}
+
+/**
+ * Reads the timings written by a run with `-T` from `path` into `ns`, with the time of each `Phase` followed by the
+ * total. Returns whether every phase was read.
+ */
+bool readTimings(const std::string& path, std::vector<long>& ns)
+{
+	std::ifstream f(path);
+	if (!f.is_open())
+		return false;
+
+	ns.assign(PHASE_COUNT + 1, -1);
+
+	std::string line;
+	while (std::getline(f, line))
+	{
+		size_t comma = line.find(',');
+		if (comma == std::string::npos)
+			continue;
+
+		std::string phase = line.substr(0, comma);
+		long value = atol(line.c_str() + comma + 1);
+
+		if (phase == "total")
+			ns[PHASE_COUNT] = value;
+
+		for (int i = 0; i < PHASE_COUNT; i++)
+		{
+			if (phase == PHASE_NAMES[i])
+				ns[i] = value;
+		}
+	}
+
+	return std::find(ns.begin(), ns.end(), -1) == ns.end();
+}
+
+/**
+ * Returns the `p`th percentile of `sorted` (in ascending order), by the nearest-rank method.
+ */
+long percentile(const std::vector<long>& sorted, double p)
+{
+	size_t rank = (size_t)std::max(1.0, std::ceil(p / 100 * sorted.size()));
+	return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+/**
+ * Returns the median of `sorted` (in ascending order).
+ */
+long median(const std::vector<long>& sorted)
+{
+	size_t m = sorted.size();
+	return (sorted[(m - 1) / 2] + sorted[m / 2]) / 2;
+}
+
+int main(int argc, char** argv)
+{
+	BenchArgs args = parseBenchArgs(argc, argv);
+
+	if (args.hasError)
+	{
+		std::cout << "Run " << argv[0] << " -h to view usage information." << std::endl;
+		return -2;
+	}
+
+	if (args.showHelp)
+	{
+		std::cout << "Usage:\n";
+		std::cout << "  " << argv[0] << " [-n SIZES] [-d D] [-k K] [-P PROCESSES] [-M MODES] [-w WARMUPS]\n";
+		std::cout << "  " << std::string(strlen(argv[0]), ' ') << " [-r REPETITIONS] [-a ALGORITHM] [-b BIN_DIR]\n";
+		std::cout << "  " << std::string(strlen(argv[0]), ' ') << " [-D DATA_DIR] [-o OUTPUT]\n";
+		std::cout << "  " << argv[0] << " -h\n";
+
+		std::cout << "\nArguments:\n";
+		std::cout << "  -n SIZES       : Comma-separated numbers of points of generated datasets (default 100000,1000000).\n";
+		std::cout << "  -d D           : Number of dimensions of each point (default 2).\n";
+		std::cout << "  -k K           : Number of clusters generated & computed (default 5).\n";
+		std::cout << "  -P PROCESSES   : Comma-separated numbers of processes of the MPI builds (default 2,4).\n";
+		std::cout << "  -M MODES       : Comma-separated builds to run (default serial,openmp,mpi_serial,mpi_openmp,\n";
+		std::cout << "                   mpi_opencl); builds whose binary is missing are skipped.\n";
+		std::cout << "  -w WARMUPS     : Number of unmeasured runs of each configuration (default 1).\n";
+		std::cout << "  -r REPETITIONS : Number of measured runs of each configuration (default 5).\n";
+		std::cout << "  -a ALGORITHM   : Algorithm used to compute clusters (default lloyd).\n";
+		std::cout << "  -b BIN_DIR     : Directory containing the binaries of each build (default ./bin).\n";
+		std::cout << "  -D DATA_DIR    : Directory to which datasets & outputs are written (default ./bench/data).\n";
+		std::cout << "  -o OUTPUT      : File to which statistics are written as CSV (default standard output).\n";
+		std::cout << "  -h             : Shows this help message.\n";
+		std::cout << "\nMPI builds are run with $MPIEXEC (default mpiexec).\n";
+
+		std::cout << std::endl;
+		return 0;
+	}
+
+	const char* mpiexec = getenv("MPIEXEC");
+	if (mpiexec == nullptr || mpiexec[0] == '\0')
+		mpiexec = "mpiexec";
+
+	mkdir(args.dataDir, 0755);
+
+	std::string dataDir = args.dataDir;
+	std::string timingsPath = dataDir + "/timings.csv";
+	std::string outputs = " -m " + dataDir + "/memberships.txt -c " + dataDir + "/centroids.txt -T " + timingsPath;
+
+	std::ofstream outputFile;
+	if (args.outputFile != nullptr)
+	{
+		outputFile.open(args.outputFile);
+		if (!outputFile.is_open())
+		{
+			std::cerr << "Failed to open " << args.outputFile << " for writing statistics" << std::endl;
+			return -6;
+		}
+	}
+
+	std::ostream& out = args.outputFile != nullptr ? outputFile : std::cout;
+	out << "mode,processes,n,d,k,phase,runs,min_ns,median_ns,p90_ns,max_ns" << std::endl;
+
+	for (int n : args.sizes)
+	{
+		// Generate the dataset, unless generated by a previous benchmark
+		std::string dataset = dataDir + "/" + std::to_string(n) + "x" + std::to_string(args.d) + "k"
+			+ std::to_string(args.k) + ".bin";
+
+		if (access(dataset.c_str(), R_OK) != 0)
+		{
+			std::cerr << "Generating " << dataset << std::endl;
+			if (!generateDataset(dataset, n, args.d, args.k))
+				return -9;
+		}
+
+		for (const std::string& mode : args.modes)
+		{
+			std::string binary = std::string(args.binDir) + "/cluster-" + mode;
+			if (access(binary.c_str(), X_OK) != 0)
+			{
+				std::cerr << "Skipping " << mode << ": " << binary << " not found (build it with make all-modes)."
+					<< std::endl;
+				continue;
+			}
+
+			// Non-MPI builds run once, in a single process.
+			bool isMpi = mode.compare(0, 4, "mpi_") == 0;
+			std::vector<int> processes = isMpi ? args.processes : std::vector<int>{ 1 };
+
+			for (int p : processes)
+			{
+				// Every run uses the same seed, such that each repetition does the same work.
+				std::string command = binary + " -k " + std::to_string(args.k) + " -i " + dataset + " -a "
+					+ args.algorithm + " -s 1" + outputs + " > /dev/null";
+
+				if (isMpi)
+					command = std::string(mpiexec) + " -n " + std::to_string(p) + " " + command;
+
+				std::cerr << "Running " << command << std::endl;
+
+				// Timings of each phase (& the total) across measured runs.
+				std::vector<std::vector<long>> samples(PHASE_COUNT + 1);
+				bool failed = false;
+
+				for (int run = 0; run < args.warmups + args.repetitions && !failed; run++)
+				{
+					unlink(timingsPath.c_str());
+
+					std::vector<long> ns;
+					if (system(command.c_str()) != 0 || !readTimings(timingsPath, ns))
+					{
+						std::cerr << "Failed to run " << mode << " with " << p << " processes; skipping." << std::endl;
+						failed = true;
+						break;
+					}
+
+					if (run < args.warmups)
+						continue;
+
+					for (int i = 0; i <= PHASE_COUNT; i++)
+						samples[i].push_back(ns[i]);
+				}
+
+				if (failed)
+					continue;
+
+				for (int i = 0; i <= PHASE_COUNT; i++)
+				{
+					std::vector<long>& s = samples[i];
+					std::sort(s.begin(), s.end());
+
+					out << mode << ',' << p << ',' << n << ',' << args.d << ',' << args.k << ','
+						<< (i < PHASE_COUNT ? PHASE_NAMES[i] : "total") << ',' << s.size() << ','
+						<< s.front() << ',' << median(s) << ',' << percentile(s, 90) << ',' << s.back() << '\n';
+				}
+
+				out.flush();
+			}
+		}
+	}
+}
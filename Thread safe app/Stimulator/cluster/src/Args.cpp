@@ -1,11 +1,117 @@
+#include <iostream>
+#include <limits.h>
+#include <string.h>
+
 #include "Args.h"
 
-Args parseArgs(int argc, char** argv)
+/**
+ * Parses the algorithm named `name` into `algorithm`, returning whether `name` is a known algorithm.
+ */
+bool parseAlgorithm(const char* name, Algorithm& algorithm)
+{
+	if (strcmp(name, "lloyd") == 0)
+		algorithm = Algorithm::Lloyd;
+	else if (strcmp(name, "sorted") == 0)
+		algorithm = Algorithm::Sorted;
+	else if (strcmp(name, "hamerly") == 0)
+		algorithm = Algorithm::Hamerly;
+	else if (strcmp(name, "exact") == 0)
+		algorithm = Algorithm::Exact;
+	else if (strcmp(name, "minibatch") == 0)
+		algorithm = Algorithm::MiniBatch;
+	else
+		return false;
+
+	return true;
+}
+
+/**
+ * Parses the aggregation `spec` (either "unique", or a positive number of histogram bins) into `aggregation` & `bins`,
+ * returning whether `spec` is valid.
+ */
+bool parseAggregation(const char* spec, Aggregation& aggregation, int& bins)
+{
+	if (strcmp(spec, "unique") == 0)
+	{
+		aggregation = Aggregation::Unique;
+		return true;
+	}
+
+	char* end;
+	long value = strtol(spec, &end, 10);
+	if (*spec == '\0' || *end != '\0' || value <= 0 || value > INT_MAX)
+		return false;
+
+	aggregation = Aggregation::Histogram;
+	bins = (int)value;
+	return true;
+}
+
+/**
+ * Parses the precision named `name` into `precision`, returning whether `name` is a known precision.
+ */
+bool parsePrecision(const char* name, Precision& precision)
 {
-	Args a;
+	if (strcmp(name, "f64") == 0)
+		precision = Precision::Double;
+	else if (strcmp(name, "f32") == 0)
+		precision = Precision::Single;
+	else
+		return false;
+
+	return true;
+}
+
+/**
+ * Parses the output format named `name` into `format`, returning whether `name` is a known format.
+ */
+bool parseOutputFormat(const char* name, OutputFormat& format)
+{
+	if (strcmp(name, "text") == 0)
+		format = OutputFormat::Text;
+	else if (strcmp(name, "binary") == 0)
+		format = OutputFormat::Binary;
+	else
+		return false;
+
+	return true;
+}
+
+/**
+ * Value returned by `getopt_long` for options without a short equivalent; beyond the range of characters, such that it
+ * can't collide with short options.
+ */
+enum LongOption
+{
+	PRECISION_OPTION = 256,
+	REBALANCE_OPTION,
+	INIT_OPTION,
+	INCREMENTAL_OPTION,
+	QUALITY_OPTION,
+};
+
+/**
+ * Long options accepted by `parseArgs`.
+ */
+const option LONG_OPTIONS[] = {
+	{ "precision", required_argument, nullptr, PRECISION_OPTION },
+	{ "rebalance", required_argument, nullptr, REBALANCE_OPTION },
+	{ "init", required_argument, nullptr, INIT_OPTION },
+	{ "incremental", required_argument, nullptr, INCREMENTAL_OPTION },
+	{ "quality", no_argument, nullptr, QUALITY_OPTION },
+	{ nullptr, 0, nullptr, 0 },
+};
+
+Args parseArgs(int argc, char** argv, const Args& defaults)
+{
+	Args a = defaults;
+	a.isParsed = false;
+
+	// Reinitializes getopt, such that arguments can be parsed more than once (i.e. per job of a batch).
+	optind = 0;
 
-	char c;
-	while ((c = getopt(argc, argv, "i:k:m:c:hv")) != -1)
+	int c;
+	while ((c = getopt_long(argc, argv, "i:k:a:b:p:g:t:e:x:r:s:m:c:f:T:l:j:hv", LONG_OPTIONS, nullptr)) != -1)
 	{
 		a.isParsed = true;
 
@@ -13,10 +119,60 @@ Args parseArgs(int argc, char** argv)
 		{
 			case 'k': { a.k = atoi(optarg); break; }
 			case 'i': { a.inputFile = optarg; break; }
+			case 'a':
+			{
+				if (!parseAlgorithm(optarg, a.algorithm))
+				{
+					std::cerr << "Unknown algorithm '" << optarg << "'." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case 'b': { a.batchSize = atoi(optarg); break; }
+			case 'p': { a.passes = atoi(optarg); break; }
+			case 'g':
+			{
+				if (!parseAggregation(optarg, a.aggregation, a.bins))
+				{
+					std::cerr << "Unknown aggregation '" << optarg << "'." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case PRECISION_OPTION:
+			{
+				if (!parsePrecision(optarg, a.precision))
+				{
+					std::cerr << "Unknown precision '" << optarg << "'." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case REBALANCE_OPTION: { a.rebalance = atoi(optarg); break; }
+			case 't': { a.threads = atoi(optarg); break; }
+			case 'e': { a.tolerance = atof(optarg); break; }
+			case 'x': { a.maxIterations = atoi(optarg); break; }
+			case 'r': { a.restarts = atoi(optarg); break; }
+			case 's': { a.seed = atol(optarg); break; }
 			case 'm': { a.membershipOutputFile = optarg; break; }
 			case 'c': { a.centroidOutputFile = optarg; break; }
+			case INIT_OPTION: { a.initialCentroidsFile = optarg; break; }
+			case INCREMENTAL_OPTION: { a.stateFile = optarg; break; }
+			case 'f':
+			{
+				if (!parseOutputFormat(optarg, a.outputFormat))
+				{
+					std::cerr << "Unknown output format '" << optarg << "'." << std::endl;
+					a.hasError = true;
+				}
+				break;
+			}
+			case 'T': { a.timingsOutputFile = optarg; break; }
+			case 'l': { a.telemetryOutputFile = optarg; break; }
+			case 'j': { a.manifestFile = optarg; break; }
 			case 'h': { a.showHelp = true; break; }
 			case 'v': { a.verbose = true; break; }
+			case QUALITY_OPTION: { a.quality = true; break; }
 			case '?': { a.hasError = true; break; }
 		}
 	}
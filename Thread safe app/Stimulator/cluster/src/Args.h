@@ -4,6 +4,94 @@
 #include <stdlib.h>
 #include <getopt.h>
 
+/**
+ * Algorithm used to compute clusters.
+ */
+enum class Algorithm
+{
+	/**
+	 * Lloyd's algorithm, comparing every value against every centroid on each iteration.
+	 */
+	Lloyd,
+
+	/**
+	 * Lloyd's algorithm over values sorted once, with centroids recomputed from prefix sums on each iteration.
+	 */
+	Sorted,
+
+	/**
+	 * Lloyd's algorithm, skipping values whose membership provably can't change according to distance bounds kept
+	 * across iterations (Hamerly's algorithm).
+	 */
+	Hamerly,
+
+	/**
+	 * Optimal clusters of 1-dimensional values, computed by dynamic programming over sorted values rather than
+	 * iteratively from initial centroids.
+	 */
+	Exact,
+
+	/**
+	 * Mini-batch k-means, streaming the input in fixed-size batches rather than reading it into memory.
+	 */
+	MiniBatch,
+};
+
+/**
+ * How values are collapsed into weighted values before clustering (see `aggregatePoints`).
+ */
+enum class Aggregation
+{
+	/**
+	 * Values are clustered as they are.
+	 */
+	None,
+
+	/**
+	 * Equal values are collapsed into one, weighted by how many there are.
+	 */
+	Unique,
+
+	/**
+	 * Values are collapsed into a fixed number of equal-width bins, each standing for the mean of its values & weighted
+	 * by how many there are.
+	 */
+	Histogram,
+};
+
+/**
+ * Precision of the values clustered, i.e. in which distances between values & centroids are computed.
+ */
+enum class Precision
+{
+	/**
+	 * 64-bit floating point values.
+	 */
+	Double,
+
+	/**
+	 * 32-bit floating point values; values are read in double precision & converted once read. Centroids are still
+	 * computed in double precision.
+	 */
+	Single,
+};
+
+/**
+ * Format in which memberships & centroids are written.
+ */
+enum class OutputFormat
+{
+	/**
+	 * A line of text per membership, and per centroid with coordinates delimited by spaces.
+	 */
+	Text,
+
+	/**
+	 * Memberships as consecutive little-endian `int32_t`s, and centroids as a binary input file (see `BinaryHeader`).
+	 */
+	Binary,
+};
+
 /**
  * Represents CLI arguments passed to the application.
  */
@@ -24,11 +112,78 @@ struct Args
 	 */
 	int k = -1;
 
+	/**
+	 * Algorithm used to compute clusters.
+	 */
+	Algorithm algorithm = Algorithm::Lloyd;
+
+	/**
+	 * Number of values per batch, when using mini-batch k-means.
+	 */
+	int batchSize = 65536;
+
+	/**
+	 * Number of passes over the input, when using mini-batch k-means.
+	 */
+	int passes = 3;
+
+	/**
+	 * How values are collapsed into weighted values before clustering.
+	 */
+	Aggregation aggregation = Aggregation::None;
+
+	/**
+	 * Number of bins, when collapsing values into a histogram.
+	 */
+	int bins = 0;
+
+	/**
+	 * Precision of the values clustered.
+	 */
+	Precision precision = Precision::Double;
+
+	/**
+	 * Number of iterations timed before repartitioning values across the processes of a group in proportion to their
+	 * throughput, in the MPI builds; 0 to keep values evenly partitioned.
+	 */
+	int rebalance = 0;
+
+	/**
+	 * Number of threads per process, in the OpenMP builds; 0 to use the OpenMP default (typically one per core).
+	 */
+	int threads = 0;
+
+	/**
+	 * Shift of centroids (relative to their magnitude) during an iteration, at or below which k-means is considered
+	 * converged.
+	 */
+	double tolerance = 0;
+
+	/**
+	 * Maximum number of iterations to execute; 0 for no limit.
+	 */
+	int maxIterations = 0;
+
+	/**
+	 * Number of independent runs from different initial centroids, of which the one with the lowest inertia is kept.
+	 */
+	int restarts = 1;
+
+	/**
+	 * Seed of the random number generator; negative to seed from the current time.
+	 */
+	long seed = -1;
+
 	/**
 	 * Whether details of the computation must be logged.
 	 */
 	bool verbose = false;
 
+	/**
+	 * Whether the clusters of the best run are scored besides their inertia (see `QualityScores`).
+	 */
+	bool quality = false;
+
 	/**
 	 * File from which values to cluster are read.
 	 */
@@ -44,6 +199,39 @@ struct Args
 	 */
 	char* centroidOutputFile = nullptr;
 
+	/**
+	 * File from which initial centroids are read (in either format of `centroidOutputFile`), rather than chosen
+	 * randomly.
+	 */
+	char* initialCentroidsFile = nullptr;
+
+	/**
+	 * File holding the state of clusters in incremental mode (see `ClusterState`): read if it exists, such that only
+	 * values appended to the input file since are clustered (from the centroids of the state, & with the members of
+	 * previous runs folded into each update of centroids), and written once done.
+	 */
+	char* stateFile = nullptr;
+
+	/**
+	 * Format in which memberships & centroids are written.
+	 */
+	OutputFormat outputFormat = OutputFormat::Text;
+
+	/**
+	 * File to which the time spent in each phase of clustering must be written, as CSV.
+	 */
+	char* timingsOutputFile = nullptr;
+
+	/**
+	 * File to which the statistics of each iteration must be written, as a line of JSON per iteration.
+	 */
+	char* telemetryOutputFile = nullptr;
+
+	/**
+	 * File listing jobs to run in one process, a line of arguments per job; jobs inherit the other arguments.
+	 */
+	char* manifestFile = nullptr;
+
 	/**
 	 * Shows a help message.
 	 */
@@ -51,9 +239,10 @@ struct Args
 };
 
 /**
- * Uses GNU Getopt (https://www.gnu.org/software/libc/manual/html_node/Getopt.html) to parse the specified CLI arguments.
- * Writes argument-related errors to `std::cerr`.
+ * Uses GNU Getopt (https://www.gnu.org/software/libc/manual/html_node/Getopt.html) to parse the specified CLI arguments
+ * (including long options, with `getopt_long`), over the values of `defaults`. Writes argument-related errors to
+ * `std::cerr`.
  */
-Args parseArgs(int argc, char** argv);
+Args parseArgs(int argc, char** argv, const Args& defaults = Args());
 
 #endif
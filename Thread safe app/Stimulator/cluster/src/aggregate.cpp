@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <numeric>
+
+#include "aggregate.h"
+
+Points Aggregate::points() const
+{
+	int n = values.size();
+	return { n, 1, n, values.data(), weights.data() };
+}
+
+int Aggregate::find(double value) const
+{
+	if (aggregation == Aggregation::Histogram)
+	{
+		int bin = width > 0 ? (int)((value - low) / width) : 0;
+		return binValues[std::clamp(bin, 0, (int)binValues.size() - 1)];
+	}
+
+	auto entry = valueIndices.find(value);
+	return entry != valueIndices.end() ? entry->second : 0;
+}
+
+void Aggregate::expand(const Points& points, const int* memberships, int* expanded) const
+{
+	const double* dim = points.dim(0);
+	for (int i = 0; i < points.n; i++)
+		expanded[i] = memberships[find(dim[i])];
+}
+
+void aggregatePoints(
+	const Points& points, Aggregation aggregation, int bins, double low, double high, Aggregate& aggregate
+)
+{
+	const double* dim = points.dim(0);
+
+	aggregate = Aggregate();
+	aggregate.aggregation = aggregation;
+
+	if (aggregation == Aggregation::Unique)
+	{
+		// Count each distinct value in a single pass, in order of first occurrence.
+		std::vector<double> values;
+		std::vector<double> weights;
+
+		for (int i = 0; i < points.n; i++)
+		{
+			auto entry = aggregate.valueIndices.try_emplace(dim[i], (int)values.size());
+			if (entry.second)
+			{
+				values.push_back(dim[i]);
+				weights.push_back(0);
+			}
+
+			++weights[entry.first->second];
+		}
+
+		// Sort the distinct values (only), & renumber them accordingly.
+		std::vector<int> order(values.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&values](int l, int r) { return values[l] < values[r]; });
+
+		for (int index : order)
+		{
+			aggregate.valueIndices[values[index]] = aggregate.values.size();
+			aggregate.values.push_back(values[index]);
+			aggregate.weights.push_back(weights[index]);
+		}
+
+		return;
+	}
+
+	// Accumulate the sum & count of each bin in a single pass.
+	aggregate.low = low;
+	aggregate.width = (high - low) / bins;
+
+	std::vector<double> sums(bins);
+	std::vector<double> counts(bins);
+	aggregate.binValues.assign(bins, -1);
+
+	for (int i = 0; i < points.n; i++)
+	{
+		int bin = aggregate.width > 0 ? (int)((dim[i] - low) / aggregate.width) : 0;
+		bin = std::clamp(bin, 0, bins - 1);
+
+		sums[bin] += dim[i];
+		++counts[bin];
+	}
+
+	// Keep the mean of each non-empty bin, weighted by its count.
+	for (int bin = 0; bin < bins; bin++)
+	{
+		if (counts[bin] == 0)
+			continue;
+
+		aggregate.binValues[bin] = aggregate.values.size();
+		aggregate.values.push_back(sums[bin] / counts[bin]);
+		aggregate.weights.push_back(counts[bin]);
+	}
+
+	// The residual is computed about the means in a second pass, rather than from sums of squares (which cancel badly).
+	for (int i = 0; i < points.n; i++)
+	{
+		double diff = dim[i] - aggregate.values[aggregate.find(dim[i])];
+		aggregate.residual += diff * diff;
+	}
+}
+
+void aggregatePoints(const Points& points, Aggregation aggregation, int bins, Aggregate& aggregate)
+{
+	const double* dim = points.dim(0);
+	auto range = std::minmax_element(dim, dim + points.n);
+
+	double low = points.n > 0 ? *range.first : 0;
+	double high = points.n > 0 ? *range.second : 0;
+	aggregatePoints(points, aggregation, bins, low, high, aggregate);
+}
@@ -0,0 +1,98 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "Args.h"
+#include "points.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+#endif
+
+/**
+ * 1-dimensional values collapsed into weighted values by `aggregatePoints`, along with what's needed to map each of the
+ * original values back to the weighted value standing for it.
+ */
+struct Aggregate
+{
+	/**
+	 * How values were collapsed.
+	 */
+	Aggregation aggregation = Aggregation::None;
+
+	/**
+	 * Weighted values in ascending order: the distinct values, or the mean of the values of each non-empty bin.
+	 */
+	std::vector<double> values;
+
+	/**
+	 * Number of original values each weighted value stands for.
+	 */
+	std::vector<double> weights;
+
+	/**
+	 * Index of the weighted value of each distinct value, when collapsed into distinct values.
+	 */
+	std::unordered_map<double, int> valueIndices;
+
+	/**
+	 * Lower bound & width of the bins, when collapsed into a histogram.
+	 */
+	double low = 0;
+	double width = 0;
+
+	/**
+	 * Index of the weighted value of each bin (or -1 if empty), when collapsed into a histogram.
+	 */
+	std::vector<int> binValues;
+
+	/**
+	 * Sum of the squared distances between each original value and the weighted value standing for it; i.e. the inertia
+	 * lost by clustering weighted values rather than the original ones (0 unless collapsed into a histogram).
+	 */
+	double residual = 0;
+
+	/**
+	 * Returns a view of the weighted values.
+	 */
+	Points points() const;
+
+	/**
+	 * Returns the index of the weighted value standing for `value`, which must be one of the original values.
+	 */
+	int find(double value) const;
+
+	/**
+	 * Expands the `memberships` of the weighted values into those of each of the original `points` (of which they were
+	 * collapsed), into `expanded`.
+	 */
+	void expand(const Points& points, const int* memberships, int* expanded) const;
+};
+
+/**
+ * Collapses the 1-dimensional `points` into weighted values into `aggregate`, as specified by `aggregation`: either a
+ * value per distinct value, or a value per non-empty bin of `bins` equal-width bins spanning `[low, high]` (which must
+ * contain every point). Clustering the weighted values costs time proportional to their number rather than that of
+ * `points`, while yielding the same sums & counts (the mean of each bin being weighted by its count).
+ */
+void aggregatePoints(
+	const Points& points, Aggregation aggregation, int bins, double low, double high, Aggregate& aggregate
+);
+
+/**
+ * Collapses `points` as specified by `aggregation` (see `aggregatePoints`), with bins spanning the range of `points`.
+ */
+void aggregatePoints(const Points& points, Aggregation aggregation, int bins, Aggregate& aggregate);
+
+#ifdef CLUSTER_MPI
+/**
+ * Collapses the `points` local to this process of `comm` as specified by `aggregation` (see `aggregatePoints`), with
+ * bins spanning the range of the points of every process, such that bins are the same across processes. Must be called
+ * by every process of `comm`.
+ */
+void aggregatePartition(const Points& points, Aggregation aggregation, int bins, MPI_Comm comm, Aggregate& aggregate);
+#endif
+
+#endif
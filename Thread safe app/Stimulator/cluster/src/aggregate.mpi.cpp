@@ -0,0 +1,24 @@
+#ifdef CLUSTER_MPI
+
+#include <algorithm>
+#include <limits>
+
+#include "aggregate.h"
+
+void aggregatePartition(const Points& points, Aggregation aggregation, int bins, MPI_Comm comm, Aggregate& aggregate)
+{
+	// Combine the range of local values across processes; the lower bound is negated, such that both are maxima.
+	const double* dim = points.dim(0);
+	double range[2] = { -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+
+	for (int i = 0; i < points.n; i++)
+	{
+		range[0] = std::max(range[0], -dim[i]);
+		range[1] = std::max(range[1], dim[i]);
+	}
+
+	MPI_Allreduce(MPI_IN_PLACE, range, 2, MPI_DOUBLE, MPI_MAX, comm);
+	aggregatePoints(points, aggregation, bins, -range[0], range[1], aggregate);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifdef CLUSTER_MPI
+
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include <mpich/mpi.h>
+#include <vector>
+
+#include "telemetry.h"
+
+/**
+ * Largest change of the number of points of any process (relative to the mean number of points per process) for which
+ * `balancePartition` keeps the current partition; timings of equally fast processes differ by noise alone, which isn't
+ * worth moving points over.
+ */
+const double REBALANCE_THRESHOLD = 0.05;
+
+/**
+ * Repartitions the points partitioned across the processes of `comm` as `counts` and `displacements` (see `partition`)
+ * in proportion to the throughput of each process, given the nanoseconds `ns` this process took to assign its points
+ * (over any number of iterations, as long as it's the same across processes). Sets `weights` to the share of points
+ * of each process.
+ *
+ * Returns whether `counts` and `displacements` changed, i.e. whether the number of points of some process changed by
+ * more than `REBALANCE_THRESHOLD`; points must then be moved with `redistribute`. Must be called by every process of
+ * `comm`. The bytes communicated are added to `traffic`, if specified.
+ */
+bool balancePartition(
+	long ns, MPI_Comm comm, std::vector<int>& counts, std::vector<int>& displacements, std::vector<double>& weights,
+	Traffic* traffic = nullptr
+);
+
+/**
+ * Moves the local `values` of `d` dimensions of each point (stored as a structure of arrays, with a stride of the
+ * number of local points) from the partition `fromCounts` & `fromDisplacements` of the processes of `comm` to the
+ * partition `toCounts` & `toDisplacements`, such that each process receives the points of its new partition in order.
+ * Must be called by every process of `comm`. The bytes communicated are added to `traffic`, if specified.
+ */
+template<typename T>
+void redistribute(
+	std::vector<T>& values, int d,
+	const std::vector<int>& fromCounts, const std::vector<int>& fromDisplacements,
+	const std::vector<int>& toCounts, const std::vector<int>& toDisplacements,
+	MPI_Comm comm, Traffic* traffic = nullptr
+);
+
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+#ifdef CLUSTER_MPI
+
+#include <algorithm>
+#include <math.h>
+#include <numeric>
+#include <stdlib.h>
+
+#include "balance.h"
+
+bool balancePartition(
+	long ns, MPI_Comm comm, std::vector<int>& counts, std::vector<int>& displacements, std::vector<double>& weights,
+	Traffic* traffic
+)
+{
+	int rank;
+	int size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	// Share the throughput of each process, in points per nanosecond; a process too quick to be timed is taken to have
+	// taken a nanosecond.
+	double throughput = counts[rank] / (double)std::max(1L, ns);
+	weights.resize(size);
+	MPI_Allgather(&throughput, 1, MPI_DOUBLE, weights.data(), 1, MPI_DOUBLE, comm);
+	if (traffic != nullptr)
+		traffic->allgather(comm, sizeof(double));
+
+	double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+	for (double& weight : weights)
+		weight = total > 0 ? weight / total : 1.0 / size;
+
+	// Give each process the points up to its cumulative share (rounded), such that counts add up to the number of
+	// points.
+	int n = std::accumulate(counts.begin(), counts.end(), 0);
+	std::vector<int> balancedCounts(size);
+	std::vector<int> balancedDisplacements(size);
+	double share = 0;
+	int start = 0;
+	int maxChange = 0;
+
+	for (int i = 0; i < size; i++)
+	{
+		share += weights[i];
+		int end = (i == size - 1) ? n : std::clamp((int)llround(share * n), start, n);
+
+		balancedCounts[i] = end - start;
+		balancedDisplacements[i] = start;
+		maxChange = std::max(maxChange, abs(balancedCounts[i] - counts[i]));
+		start = end;
+	}
+
+	if (maxChange <= REBALANCE_THRESHOLD * n / size)
+		return false;
+
+	counts.swap(balancedCounts);
+	displacements.swap(balancedDisplacements);
+	return true;
+}
+
+template<typename T>
+void redistribute(
+	std::vector<T>& values, int d,
+	const std::vector<int>& fromCounts, const std::vector<int>& fromDisplacements,
+	const std::vector<int>& toCounts, const std::vector<int>& toDisplacements,
+	MPI_Comm comm, Traffic* traffic
+)
+{
+	int rank;
+	int size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	// Send each process the overlap of the previous slice of this process with its new slice, & receive the overlap of
+	// the new slice of this process with its previous slice; slices being consecutive, points stay in order.
+	std::vector<int> sendCounts(size);
+	std::vector<int> sendDisplacements(size);
+	std::vector<int> receiveCounts(size);
+	std::vector<int> receiveDisplacements(size);
+
+	int fromStart = fromDisplacements[rank];
+	int fromEnd = fromStart + fromCounts[rank];
+	int toStart = toDisplacements[rank];
+	int toEnd = toStart + toCounts[rank];
+
+	for (int p = 0; p < size; p++)
+	{
+		int start = std::max(fromStart, toDisplacements[p]);
+		int end = std::min(fromEnd, toDisplacements[p] + toCounts[p]);
+		sendCounts[p] = std::max(0, end - start);
+		sendDisplacements[p] = sendCounts[p] > 0 ? start - fromStart : 0;
+
+		start = std::max(toStart, fromDisplacements[p]);
+		end = std::min(toEnd, fromDisplacements[p] + fromCounts[p]);
+		receiveCounts[p] = std::max(0, end - start);
+		receiveDisplacements[p] = receiveCounts[p] > 0 ? start - toStart : 0;
+	}
+
+	// Exchange each dimension in turn, as values of any type are exchanged as opaque elements of their size.
+	MPI_Datatype type;
+	MPI_Type_contiguous(sizeof(T), MPI_BYTE, &type);
+	MPI_Type_commit(&type);
+
+	std::vector<T> redistributed((size_t)toCounts[rank] * d);
+	for (int j = 0; j < d; j++)
+	{
+		MPI_Alltoallv(
+			values.data() + (size_t)j * fromCounts[rank], sendCounts.data(), sendDisplacements.data(), type,
+			redistributed.data() + (size_t)j * toCounts[rank], receiveCounts.data(), receiveDisplacements.data(), type,
+			comm
+		);
+	}
+
+	MPI_Type_free(&type);
+	values.swap(redistributed);
+
+	if (traffic != nullptr)
+		traffic->alltoallv(comm, sendCounts.data(), receiveCounts.data(), sizeof(T) * d);
+}
+
+template void redistribute(
+	std::vector<double>&, int, const std::vector<int>&, const std::vector<int>&, const std::vector<int>&,
+	const std::vector<int>&, MPI_Comm, Traffic*
+);
+template void redistribute(
+	std::vector<int>&, int, const std::vector<int>&, const std::vector<int>&, const std::vector<int>&,
+	const std::vector<int>&, MPI_Comm, Traffic*
+);
+
+#endif
@@ -1,50 +1,27 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
 #include <string.h>
 #include <vector>
 #include <chrono>
+#include <cmath>
 
 #include "Args.h"
 #include "util.h"
 #include "kmeans.h"
+#include "writer.h"
 
 namespace chrono = std::chrono;
 
-int main(int argc, char** argv)
+/**
+ * Clusters the values of `args.inputFile` for `args`, writing the requested outputs & reporting how long it took.
+ * Returns 0 on success, or a negative error code otherwise.
+ */
+int runJob(const Args& args)
 {
 	// Seed RNG
-	srand(time(nullptr));
-
-	// Parse args
-	char* progName = argv[0];
-	if (progName[0] == '\0')
-		progName = strdup("matrix-multiplier");
-
-	Args args = parseArgs(argc, argv);
-
-	if (args.hasError)
-	{
-		std::cout << "Run " << progName << " -h to view usage information." << std::endl;
-		return -2;
-	}
-
-	if (!args.isParsed || args.showHelp)
-	{
-		std::cout << "Usage:\n";
-		std::cout << "  " << progName << " -k K -i INPUT [-m MEMBERSHIP_OUTPUT] [-c CENTROID_OUTPUT] [-v]\n";
-		std::cout << "  " << progName << " -h\n";
-
-		std::cout << "\nArguments:\n";
-		std::cout << "  -k K                 : Number of clusters to be computed.\n";
-		std::cout << "  -i INPUT             : File from which values to cluster are read.\n";
-		std::cout << "  -m MEMBERSHIP_OUTPUT : File to which computed memberships should be written.\n";
-		std::cout << "  -c CENTROID_OUTPUT   : File to which computed centroids should be written.\n";
-		std::cout << "  -v                   : Print (verbose) details during computation.\n";
-		std::cout << "  -h                   : Shows this help message.\n";
-
-		std::cout << std::endl;
-		return args.showHelp ? 0 : -1;
-	}
+	srand(args.seed >= 0 ? args.seed : time(nullptr));
 
 	if (args.inputFile == nullptr)
 	{
@@ -62,43 +39,271 @@ int main(int argc, char** argv)
 		return result.returnCode;
 
 	auto tDurationNs = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - tStart).count();
+	tDurationNs -= result.timings[Phase::Load] + result.timings[Phase::Write];
 
-	// Write memberships
-	if (args.membershipOutputFile != nullptr)
+	Clock::time_point tWrite = Clock::now();
+
+	// Write memberships, unless already written while clustering
+	if (args.membershipOutputFile != nullptr && !result.memberships.empty())
+	{
+		bool written = writeMemberships(
+			args.membershipOutputFile, result.n, result.memberships.data(), args.outputFormat, args.threads
+		);
+
+		if (!written)
+			return -6;
+
+		std::cout << "Wrote memberships to " << args.membershipOutputFile << std::endl;
+	}
+
+	// Write centroids
+	if (args.centroidOutputFile != nullptr)
+	{
+		if (!writeCentroids(args.centroidOutputFile, args.k, result.d, result.centroids.data(), args.outputFormat))
+			return -7;
+
+		std::cout << "Wrote centroids to " << args.centroidOutputFile << std::endl;
+	}
+
+	// Write the state of clusters, for the next incremental run
+	if (args.stateFile != nullptr)
+	{
+		if (!writeState(args.stateFile, result.state))
+			return -20;
+
+		std::cout << "Wrote state to " << args.stateFile << std::endl;
+	}
+
+	// Write telemetry
+	if (args.telemetryOutputFile != nullptr)
 	{
-		std::ofstream f(args.membershipOutputFile);
+		std::ofstream f(args.telemetryOutputFile);
 		if (!f.is_open())
 		{
-			std::cerr << "Failed to open " << args.membershipOutputFile << " for writing memberships" << std::endl;
-			return -6;
+			std::cerr << "Failed to open " << args.telemetryOutputFile << " for writing telemetry" << std::endl;
+			return -14;
 		}
 
-		for (int i = 0; i < result.n; i++)
-			f << result.memberships[i] << '\n';
-
+		f << result.telemetry.lines;
 		f.close();
 
-		std::cout << "Wrote memberships to " << args.membershipOutputFile << std::endl;
+		std::cout << "Wrote telemetry to " << args.telemetryOutputFile << std::endl;
 	}
 
-	// Write centroids
-	if (args.centroidOutputFile != nullptr)
+	result.timings.lap(Phase::Write, tWrite);
+
+	// Write timings
+	if (args.timingsOutputFile != nullptr)
 	{
-		std::ofstream f(args.centroidOutputFile);
+		std::ofstream f(args.timingsOutputFile);
 		if (!f.is_open())
 		{
-			std::cerr << "Failed to open " << args.centroidOutputFile << " for writing centroids" << std::endl;
-			return -7;
+			std::cerr << "Failed to open " << args.timingsOutputFile << " for writing timings" << std::endl;
+			return -13;
 		}
 
-		for (int i = 0; i < args.k; i++)
-			f << result.centroids[i] << '\n';
+		f << "phase,ns\n";
+		for (int i = 0; i < PHASE_COUNT; i++)
+			f << PHASE_NAMES[i] << ',' << result.timings.ns[i] << '\n';
+		f << "total," << tDurationNs + result.timings[Phase::Load] + result.timings[Phase::Write] << '\n';
 
 		f.close();
-
-		std::cout << "Wrote centroids to " << args.centroidOutputFile << std::endl;
 	}
 
-	// Output time
+	if (result.inertia >= 0)
+		std::cout << "inertia = " << result.inertia << std::endl;
+
+	if (result.scores.daviesBouldin >= 0)
+		std::cout << "daviesBouldin = " << result.scores.daviesBouldin << std::endl;
+
+	if (!std::isnan(result.scores.silhouette))
+		std::cout << "silhouette = " << result.scores.silhouette << std::endl;
+
+	// Output times
+	long loadNs = result.timings[Phase::Load];
+	std::cout << "Loading took " << loadNs << " ns" << " (" << (loadNs / 1e9f) << " s)" << std::endl;
 	std::cout << "Clustering took " << tDurationNs << " ns" << " (" << (tDurationNs / 1e9f) << " s)" << std::endl;
+
+	return 0;
+}
+
+/**
+ * Runs a job for each line of the manifest at `args.manifestFile`, each line holding arguments (delimited by
+ * whitespace) parsed over `args`; blank lines & lines starting with '#' are skipped. Jobs run back-to-back in this
+ * process, such that state set up by `initialize` is shared by every job. Every process (when distributed) reads the
+ * manifest, and runs each job.
+ *
+ * Returns 0 if every job succeeded; otherwise, the error code of the last job that failed.
+ */
+int runBatch(const char* progName, const Args& args, bool isRoot)
+{
+	std::ifstream manifest(args.manifestFile);
+	if (!manifest.is_open())
+	{
+		if (isRoot)
+			std::cerr << "Failed to open " << args.manifestFile << " for reading jobs" << std::endl;
+		return -15;
+	}
+
+	Args defaults = args;
+	defaults.manifestFile = nullptr;
+
+	int returnCode = 0;
+	int jobs = 0;
+	int failed = 0;
+	std::string line;
+
+	for (int lineNumber = 1; std::getline(manifest, line); lineNumber++)
+	{
+		// Split the line into arguments, which point into `tokens` for the duration of the job.
+		std::istringstream ss(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (ss >> token)
+			tokens.push_back(token);
+
+		if (tokens.empty() || tokens[0][0] == '#')
+			continue;
+
+		std::vector<char*> jobArgv = { (char*)progName };
+		for (std::string& t : tokens)
+			jobArgv.push_back(&t[0]);
+		jobArgv.push_back(nullptr);
+
+		++jobs;
+		if (isRoot)
+			std::cout << "job = " << args.manifestFile << ':' << lineNumber << std::endl;
+
+		Args jobArgs = parseArgs(jobArgv.size() - 1, jobArgv.data(), defaults);
+		int jobReturnCode = jobArgs.hasError ? -2 : runJob(jobArgs);
+
+		if (jobReturnCode != 0)
+		{
+			if (isRoot)
+			{
+				std::cerr << args.manifestFile << ':' << lineNumber << ": Job failed with code " << jobReturnCode
+					<< std::endl;
+			}
+
+			returnCode = jobReturnCode;
+			++failed;
+		}
+
+		std::cout.flush();
+	}
+
+	if (isRoot)
+		std::cout << "jobs = " << jobs << " (" << failed << " failed)" << std::endl;
+
+	return returnCode;
+}
+
+int main(int argc, char** argv)
+{
+	// Parse args
+	char* progName = argv[0];
+	if (progName[0] == '\0')
+		progName = strdup("matrix-multiplier");
+
+	Args args = parseArgs(argc, argv);
+
+	if (args.hasError)
+	{
+		std::cout << "Run " << progName << " -h to view usage information." << std::endl;
+		return -2;
+	}
+
+	if (!args.isParsed || args.showHelp)
+	{
+		std::cout << "Usage:\n";
+		std::cout << "  " << progName << " -k K -i INPUT [-a ALGORITHM] [-b BATCH_SIZE] [-p PASSES] [-g AGGREGATION]\n";
+		std::cout << "  " << std::string(strlen(progName), ' ') << " [--precision TYPE] [--rebalance ITERATIONS]\n";
+		std::cout << "  " << std::string(strlen(progName), ' ') << " [--init CENTROIDS] [--incremental STATE]\n";
+		std::cout << "  " << std::string(strlen(progName), ' ') << " [-t THREADS] [-e TOLERANCE] [-x MAX_ITERATIONS]\n";
+		std::cout << "  " << std::string(strlen(progName), ' ') << " [-r RESTARTS] [-s SEED] [-m MEMBERSHIP_OUTPUT]\n";
+		std::cout << "  " << std::string(strlen(progName), ' ') << " [-c CENTROID_OUTPUT] [-f FORMAT] [-T TIMINGS_OUTPUT]\n";
+		std::cout << "  " << std::string(strlen(progName), ' ') << " [-l TELEMETRY_OUTPUT] [-j MANIFEST] [--quality] [-v]\n";
+		std::cout << "  " << progName << " -h\n";
+
+		std::cout << "\nArguments:\n";
+		std::cout << "  -k K                 : Number of clusters to be computed.\n";
+		std::cout << "  -i INPUT             : File from which values to cluster are read; one per line, with a column per\n";
+		std::cout << "                         dimension. Binary files written by cluster-gen.py -b are memory-mapped.\n";
+		std::cout << "  -a ALGORITHM         : Algorithm used to compute clusters; one of:\n";
+		std::cout << "                           lloyd     - Lloyd's algorithm (default).\n";
+		std::cout << "                           sorted    - Lloyd's algorithm over sorted values & prefix sums (serial\n";
+		std::cout << "                                       & OpenMP only).\n";
+		std::cout << "                           hamerly   - Lloyd's algorithm, pruned with distance bounds (not OpenCL).\n";
+		std::cout << "                           exact     - Optimal clusters of 1-dimensional values, by dynamic\n";
+		std::cout << "                                       programming over sorted values; replaces restarts (serial &\n";
+		std::cout << "                                       OpenMP only, threaded).\n";
+		std::cout << "                           minibatch - Mini-batch k-means, streaming the input in batches rather than\n";
+		std::cout << "                                       reading it into memory (serial & OpenMP only).\n";
+		std::cout << "  -b BATCH_SIZE        : Number of values per batch of minibatch (default 65536).\n";
+		std::cout << "  -p PASSES            : Number of passes over the input of minibatch (default 3).\n";
+		std::cout << "  -g AGGREGATION       : Collapses 1-dimensional values into weighted values before clustering, with\n";
+		std::cout << "                         memberships expanded back to every value once clustered (not minibatch);\n";
+		std::cout << "                         one of:\n";
+		std::cout << "                           unique - A weighted value per distinct value.\n";
+		std::cout << "                           BINS   - A weighted value per non-empty bin of BINS equal-width bins,\n";
+		std::cout << "                                    standing for the mean of its values.\n";
+		std::cout << "  --precision TYPE     : Precision of the values clustered; one of:\n";
+		std::cout << "                           f64 - 64-bit floating point values (default).\n";
+		std::cout << "                           f32 - 32-bit floating point values, converted once read; halves the memory\n";
+		std::cout << "                                 traffic of assigning values (not minibatch).\n";
+		std::cout << "  --rebalance ITERATIONS\n";
+		std::cout << "                       : Times assigning values on each node during the first ITERATIONS iterations,\n";
+		std::cout << "                         then repartitions values across the nodes of each group in proportion to\n";
+		std::cout << "                         their throughput, balancing nodes of unequal speed (MPI builds, not with -g;\n";
+		std::cout << "                         default 0, i.e. values are partitioned evenly).\n";
+		std::cout << "  --init CENTROIDS     : File from which initial centroids are read (e.g. written by -c), replacing\n";
+		std::cout << "                         k-means++ & restarts (lloyd & hamerly only).\n";
+		std::cout << "  --incremental STATE  : File holding the count & centroid of each cluster of the values clustered by\n";
+		std::cout << "                         previous runs, i.e. the first values of INPUT. Only the values appended since\n";
+		std::cout << "                         are clustered, from those centroids & with those clusters folded into each\n";
+		std::cout << "                         update; memberships & inertia cover only the new values. Created if missing,\n";
+		std::cout << "                         & updated once done (lloyd & hamerly, serial & OpenMP only).\n";
+		std::cout << "  -t THREADS           : Number of threads per process of the OpenMP builds (default one per core).\n";
+		std::cout << "  -e TOLERANCE         : Stop once centroids shift by no more than TOLERANCE during an iteration,\n";
+		std::cout << "                         relative to their magnitude (default 0).\n";
+		std::cout << "  -x MAX_ITERATIONS    : Stop after MAX_ITERATIONS iterations (default no limit).\n";
+		std::cout << "  -r RESTARTS          : Number of runs from different initial centroids, keeping the one of lowest\n";
+		std::cout << "                         inertia (default 1). Runs execute concurrently across threads, or groups of\n";
+		std::cout << "                         nodes in the MPI builds (not minibatch).\n";
+		std::cout << "  -s SEED              : Seed of the random number generator (default the current time).\n";
+		std::cout << "  -m MEMBERSHIP_OUTPUT : File to which computed memberships should be written.\n";
+		std::cout << "  -c CENTROID_OUTPUT   : File to which computed centroids should be written.\n";
+		std::cout << "  -f FORMAT            : Format in which memberships & centroids are written; one of:\n";
+		std::cout << "                           text   - A line per membership & centroid (default).\n";
+		std::cout << "                           binary - Memberships as 32-bit integers, & centroids as a binary input\n";
+		std::cout << "                                    file. In the MPI builds, each node writes its own memberships.\n";
+		std::cout << "  -T TIMINGS_OUTPUT    : File to which the time spent in each phase (load, scatter, aggregate,\n";
+		std::cout << "                         seed, assign, reduce, gather, score & write) should be written, as CSV.\n";
+		std::cout << "  -l TELEMETRY_OUTPUT  : File to which statistics of each iteration (inertia, changed memberships,\n";
+		std::cout << "                         largest centroid shift, wall time & bytes communicated per node) should be\n";
+		std::cout << "                         written, as a line of JSON per iteration & node (not sorted, exact or\n";
+		std::cout << "                         minibatch); & the node weights chosen by --rebalance as a line of their own.\n";
+		std::cout << "  -j MANIFEST          : File listing jobs to run back-to-back in one process (sharing MPI & OpenCL\n";
+		std::cout << "                         setup); a line of arguments per job (e.g. -i INPUT -k K -m MEMBERSHIP_OUTPUT),\n";
+		std::cout << "                         combined with the others specified.\n";
+		std::cout << "  --quality            : Scores the clusters found besides their inertia, to compare different K: the\n";
+		std::cout << "                         Davies-Bouldin index (lower is better), & the mean silhouette of\n";
+		std::cout << "                         1-dimensional values (higher is better; computed exactly from sorted values,\n";
+		std::cout << "                         across threads & nodes). Not minibatch.\n";
+		std::cout << "  -v                   : Print (verbose) details during computation.\n";
+		std::cout << "  -h                   : Shows this help message.\n";
+
+		std::cout << std::endl;
+		return args.showHelp ? 0 : -1;
+	}
+
+	// Set up state shared by every job, then run the job of the arguments (or each job of the manifest)
+	bool isRoot = true;
+	int returnCode = initialize(args, isRoot);
+
+	if (returnCode == 0)
+		returnCode = args.manifestFile != nullptr ? runBatch(progName, args, isRoot) : runJob(args);
+
+	finalize();
+	return returnCode;
 }
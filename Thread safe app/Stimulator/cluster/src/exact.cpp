@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "exact.h"
+#include "parallel.h"
+
+/**
+ * Prefix sums of the weights, values & squared values of sorted values (where element `i` is the sum over the first `i`
+ * values), from which the cost of any range of them as one cluster is computed in O(1).
+ */
+struct PrefixSums
+{
+	std::vector<double> weights;
+	std::vector<double> sums;
+	std::vector<double> squares;
+
+	/**
+	 * Returns the sum of the squared distances between the sorted values `[i, j)` and their mean (times their weight).
+	 */
+	double cost(int i, int j) const
+	{
+		double weight = weights[j] - weights[i];
+		if (weight <= 0)
+			return 0;
+
+		// Rounding may leave a small negative difference when every value of the range is equal.
+		double sum = sums[j] - sums[i];
+		return std::max(0.0, squares[j] - squares[i] - sum * sum / weight);
+	}
+};
+
+/**
+ * Costs of the sorted values `[lo, hi)` as seen by a row of the table: value `i` of the range is sorted value `lo + i`
+ * forwards, or `hi - 1 - i` if `reversed` (such that the rows split the values from the last one backwards).
+ */
+struct RangeCosts
+{
+	const PrefixSums& prefix;
+	int lo;
+	int hi;
+	bool reversed;
+
+	/**
+	 * Returns the number of values of the range.
+	 */
+	int size() const
+	{
+		return hi - lo;
+	}
+
+	/**
+	 * Returns the cost of values `[i, j)` of the range as one cluster.
+	 */
+	double cost(int i, int j) const
+	{
+		return reversed ? prefix.cost(hi - j, hi - i) : prefix.cost(lo + i, lo + j);
+	}
+};
+
+/**
+ * Columns `[first, last]` of a row of the table, whose best splits are known to lie within `[splitFirst, splitLast]`.
+ */
+struct Span
+{
+	int first;
+	int last;
+	int splitFirst;
+	int splitLast;
+};
+
+/**
+ * Computes column `j` of a row of the table into `row` from the `previous` row, considering splits within
+ * `[splitFirst, splitLast]`. Returns the best split.
+ */
+int solveColumn(
+	const RangeCosts& costs, const std::vector<double>& previous, std::vector<double>& row,
+	int j, int splitFirst, int splitLast
+)
+{
+	int best = splitFirst;
+	double bestCost = std::numeric_limits<double>::infinity();
+
+	for (int i = splitFirst; i <= std::min(splitLast, j - 1); i++)
+	{
+		double cost = previous[i] + costs.cost(i, j);
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			best = i;
+		}
+	}
+
+	row[j] = bestCost;
+	return best;
+}
+
+/**
+ * Computes the columns of `span` by divide & conquer: the middle column first, whose best split bounds those of the
+ * columns on either side of it.
+ */
+void solveSpan(const RangeCosts& costs, const std::vector<double>& previous, std::vector<double>& row, Span span)
+{
+	if (span.first > span.last)
+		return;
+
+	int mid = span.first + (span.last - span.first) / 2;
+	int best = solveColumn(costs, previous, row, mid, span.splitFirst, span.splitLast);
+
+	solveSpan(costs, previous, row, { span.first, mid - 1, span.splitFirst, best });
+	solveSpan(costs, previous, row, { mid + 1, span.last, best, span.splitLast });
+}
+
+/**
+ * Computes into `row` the least cost of splitting the first `j` values of `costs` into `clusters` clusters, for each
+ * `j` that leaves at least a value to each of the clusters following them (of `total` clusters over every value of
+ * `costs`), across `threads` threads. Other columns are infinite, or left over from previous rows.
+ */
+void solveRows(const RangeCosts& costs, int clusters, int total, std::vector<double>& row, int threads)
+{
+	int n = costs.size();
+
+	// Row m holds the least cost of splitting the first j values into m + 1 clusters, only the last 2 of which are
+	// kept. The first row has a single cluster, i.e. no split.
+	std::vector<double> previous(n + 1, std::numeric_limits<double>::infinity());
+	row.assign(n + 1, std::numeric_limits<double>::infinity());
+
+	for (int j = 1; j <= n - total + 1; j++)
+		row[j] = costs.cost(0, j);
+
+	for (int m = 1; m < clusters; m++)
+	{
+		std::swap(previous, row);
+
+		int first = m + 1;
+		int last = n - total + m + 1;
+		std::vector<Span> spans = { { first, last, m, last - 1 } };
+
+		// Solve the middle column of each span breadth-first, each level across threads, until there are enough spans
+		// to keep every thread busy; then solve the remaining spans across threads, each by divide & conquer.
+		while (!spans.empty() && (int)spans.size() < threads * 4)
+		{
+			std::vector<Span> halves(spans.size() * 2);
+			parallelFor(spans.size(), threads, [&](int s)
+			{
+				Span span = spans[s];
+				int mid = span.first + (span.last - span.first) / 2;
+				int best = solveColumn(costs, previous, row, mid, span.splitFirst, span.splitLast);
+
+				halves[s * 2] = { span.first, mid - 1, span.splitFirst, best };
+				halves[s * 2 + 1] = { mid + 1, span.last, best, span.splitLast };
+			});
+
+			spans.clear();
+			std::copy_if(halves.begin(), halves.end(), std::back_inserter(spans), [](const Span& span)
+			{
+				return span.first <= span.last;
+			});
+		}
+
+		parallelFor(spans.size(), threads, [&](int s)
+		{
+			solveSpan(costs, previous, row, spans[s]);
+		});
+	}
+}
+
+/**
+ * Finds the bounds between the optimal `clusters` clusters of the sorted values `[lo, hi)` into `bounds` (where cluster
+ * `c` starts at `bounds[c]`; `bounds[0]` & `bounds[clusters]` being `lo` & `hi`), across `threads` threads.
+ *
+ * Rather than keeping the best split of every cell of the table to trace clusters back, the least costs of the first
+ * half of the clusters (forwards) & of the other half (backwards, from the last value) meet at the best bound between
+ * them, & each half is solved again over its own values. Each level of recursion solves half as many rows as the one
+ * above it, over the same number of values at most, so clusters are found in about twice the time of a single pass.
+ */
+void findBounds(const PrefixSums& prefix, int lo, int hi, int clusters, int* bounds, int threads)
+{
+	if (clusters == 1)
+		return;
+
+	int n = hi - lo;
+	int forwardClusters = clusters / 2;
+	int backwardClusters = clusters - forwardClusters;
+	int split = forwardClusters;
+
+	{
+		std::vector<double> forward;
+		std::vector<double> backward;
+		solveRows({ prefix, lo, hi, false }, forwardClusters, clusters, forward, threads);
+		solveRows({ prefix, lo, hi, true }, backwardClusters, clusters, backward, threads);
+
+		double bestCost = std::numeric_limits<double>::infinity();
+		for (int j = forwardClusters; j <= n - backwardClusters; j++)
+		{
+			double cost = forward[j] + backward[n - j];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				split = j;
+			}
+		}
+	}
+
+	bounds[forwardClusters] = lo + split;
+	findBounds(prefix, lo, lo + split, forwardClusters, bounds, threads);
+	findBounds(prefix, lo + split, hi, backwardClusters, bounds + forwardClusters, threads);
+}
+
+template<typename T>
+void exactKmeans(int n, const T* arr, const double* weights, int k, double* centroids, int* memberships, int threads)
+{
+	// Sort (indices of) values once, & compute their prefix sums about the median, such that squares stay small enough
+	// for costs not to cancel out.
+	std::vector<int> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [arr](int l, int r) { return arr[l] < arr[r]; });
+
+	double median = arr[order[n / 2]];
+	PrefixSums prefix;
+	prefix.weights.resize(n + 1);
+	prefix.sums.resize(n + 1);
+	prefix.squares.resize(n + 1);
+
+	for (int i = 0; i < n; i++)
+	{
+		double weight = weights == nullptr ? 1 : weights[order[i]];
+		double value = arr[order[i]] - median;
+		prefix.weights[i + 1] = prefix.weights[i] + weight;
+		prefix.sums[i + 1] = prefix.sums[i] + weight * value;
+		prefix.squares[i + 1] = prefix.squares[i] + weight * value * value;
+	}
+
+	// Find the bounds of the optimal clusters, & populate centroids & memberships from them.
+	std::vector<int> bounds(k + 1);
+	bounds[0] = 0;
+	bounds[k] = n;
+	findBounds(prefix, 0, n, k, bounds.data(), threads);
+
+	for (int c = 0; c < k; c++)
+	{
+		double weight = prefix.weights[bounds[c + 1]] - prefix.weights[bounds[c]];
+		double sum = prefix.sums[bounds[c + 1]] - prefix.sums[bounds[c]];
+		centroids[c] = median + (weight > 0 ? sum / weight : 0);
+
+		for (int i = bounds[c]; i < bounds[c + 1]; i++)
+			memberships[order[i]] = c;
+	}
+}
+
+template void exactKmeans(int, const float*, const double*, int, double*, int*, int);
+template void exactKmeans(int, const double*, const double*, int, double*, int*, int);
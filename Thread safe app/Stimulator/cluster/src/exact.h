@@ -0,0 +1,20 @@
+#ifndef EXACT_H
+#define EXACT_H
+
+/**
+ * Computes the optimal (i.e. least inertia) clustering of the `n` values of `arr` (weighted by `weights`, if specified)
+ * into `k` clusters, populating `centroids` (in ascending order) and `memberships` (of length `n`, referring to
+ * `centroids` in that order).
+ *
+ * Optimal clusters of 1-dimensional values are contiguous once values are sorted, so they're found by dynamic
+ * programming over sorted values: the least cost of splitting the first `j` values into `m` clusters is the least, over
+ * `i`, of that of splitting the first `i` values into `m - 1` clusters plus the cost of values `[i, j)` as one cluster
+ * (read off prefix sums in O(1)). The best `i` never decreases as `j` grows, so each of the `k` rows of the table is
+ * computed by divide & conquer in O(n log n), across `threads` threads. Only the last 2 rows are kept, with clusters
+ * found by splitting them in halves recursively rather than traced back from the best split of each cell; i.e. memory
+ * is O(n), at about twice the time.
+ */
+template<typename T>
+void exactKmeans(int n, const T* arr, const double* weights, int k, double* centroids, int* memberships, int threads);
+
+#endif
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+#include "hamerly.h"
+
+/**
+ * Returns the Euclidean distance between the `d`-dimensional points `l` and `r`.
+ */
+double distance(int d, const double* l, const double* r)
+{
+	double acc = 0;
+	for (int j = 0; j < d; j++)
+		acc += (l[j] - r[j]) * (l[j] - r[j]);
+	return sqrt(acc);
+}
+
+/**
+ * Returns the squared Euclidean distance between point `i` of `points` and the `points.d`-dimensional `centroid`.
+ */
+template<typename T>
+double squaredDistance(const BasicPoints<T>& points, int i, const double* centroid)
+{
+	double acc = 0;
+	for (int j = 0; j < points.d; j++)
+	{
+		double diff = points.dim(j)[i] - centroid[j];
+		acc += diff * diff;
+	}
+	return acc;
+}
+
+/**
+ * Compares point `i` of `points` against each of the `k` `centroids`, storing the index of the closest into `closest`,
+ * the distance to it into `upper`, and the distance to the second closest into `lower`.
+ */
+template<typename T>
+void scanCentroids(
+	const BasicPoints<T>& points, int i,
+	int k, const double* centroids,
+	int& closest, double& upper, double& lower
+)
+{
+	closest = 0;
+	upper = std::numeric_limits<double>::infinity();
+	lower = std::numeric_limits<double>::infinity();
+
+	for (int c = 0; c < k; c++)
+	{
+		double diff = sqrt(squaredDistance(points, i, centroids + c * points.d));
+		if (diff < upper)
+		{
+			lower = upper;
+			upper = diff;
+			closest = c;
+		}
+		else if (diff < lower)
+		{
+			lower = diff;
+		}
+	}
+}
+
+template<typename T>
+int hamerlyAssignAndAccumulate(
+	const BasicPoints<T>& points,
+	int k, const double* centroids,
+	int* memberships,
+	double* sums, double* counts, double* squares,
+	HamerlyState& state
+)
+{
+	int n = points.n;
+	int d = points.d;
+
+	int changed = 0;
+	double squared = 0;
+	state.scanned = 0;
+
+	if (state.centroids.empty())
+	{
+		// Initialize bounds by comparing every point against every centroid.
+		state.assignments.resize(n);
+		state.upper.resize(n);
+		state.lower.resize(n);
+
+		for (int i = 0; i < n; i++)
+		{
+			scanCentroids(points, i, k, centroids, state.assignments[i], state.upper[i], state.lower[i]);
+			squared += points.weight(i) * state.upper[i] * state.upper[i];
+			++state.scanned;
+			++changed;
+		}
+	}
+	else
+	{
+		// Compute how far each centroid moved, & the 2 largest shifts.
+		std::vector<double> shifts(k);
+		int maxShiftIdx = 0;
+		double maxShift = 0;
+		double secondMaxShift = 0;
+
+		for (int c = 0; c < k; c++)
+		{
+			shifts[c] = distance(d, centroids + c * d, state.centroids.data() + c * d);
+			if (shifts[c] > maxShift)
+			{
+				secondMaxShift = maxShift;
+				maxShift = shifts[c];
+				maxShiftIdx = c;
+			}
+			else if (shifts[c] > secondMaxShift)
+			{
+				secondMaxShift = shifts[c];
+			}
+		}
+
+		// Compute half the distance between each centroid & the centroid closest to it.
+		std::vector<double> halfGaps(k, std::numeric_limits<double>::infinity());
+		for (int c = 0; c < k; c++)
+		{
+			for (int o = c + 1; o < k; o++)
+			{
+				double halfGap = distance(d, centroids + c * d, centroids + o * d) / 2;
+				halfGaps[c] = std::min(halfGaps[c], halfGap);
+				halfGaps[o] = std::min(halfGaps[o], halfGap);
+			}
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			int a = state.assignments[i];
+
+			// Loosen bounds by how far centroids moved.
+			state.upper[i] += shifts[a];
+			state.lower[i] -= (a == maxShiftIdx) ? secondMaxShift : maxShift;
+
+			double bound = std::max(halfGaps[a], state.lower[i]);
+			if (state.upper[i] <= bound)
+			{
+				if (squares != nullptr)
+					squared += points.weight(i) * squaredDistance(points, i, centroids + a * d);
+				continue;
+			}
+
+			// Tighten the upper bound, & only compare against every centroid if bounds still overlap.
+			double acc = squaredDistance(points, i, centroids + a * d);
+			state.upper[i] = sqrt(acc);
+
+			if (state.upper[i] <= bound)
+			{
+				squared += points.weight(i) * acc;
+				continue;
+			}
+
+			scanCentroids(points, i, k, centroids, state.assignments[i], state.upper[i], state.lower[i]);
+			squared += points.weight(i) * state.upper[i] * state.upper[i];
+			++state.scanned;
+			changed += (state.assignments[i] != a);
+		}
+	}
+
+	state.centroids.assign(centroids, centroids + k * d);
+
+	if (squares != nullptr)
+		*squares += squared;
+
+	// Store memberships, & move points whose membership changed between the sums & counts of their centroids.
+	for (int i = 0; i < n; i++)
+	{
+		int previous = memberships[i];
+		int current = state.assignments[i];
+		if (previous == current)
+			continue;
+
+		memberships[i] = current;
+		double weight = points.weight(i);
+
+		if (previous >= 0)
+		{
+			counts[previous] -= weight;
+			for (int j = 0; j < d; j++)
+				sums[previous * d + j] -= weight * points.dim(j)[i];
+		}
+
+		counts[current] += weight;
+		for (int j = 0; j < d; j++)
+			sums[current * d + j] += weight * points.dim(j)[i];
+	}
+
+	return changed;
+}
+
+template int hamerlyAssignAndAccumulate(
+	const BasicPoints<float>&, int, const double*, int*, double*, double*, double*, HamerlyState&
+);
+template int hamerlyAssignAndAccumulate(
+	const BasicPoints<double>&, int, const double*, int*, double*, double*, double*, HamerlyState&
+);
@@ -0,0 +1,60 @@
+#ifndef HAMERLY_H
+#define HAMERLY_H
+
+#include <vector>
+
+#include "points.h"
+
+/**
+ * Per-point state kept across iterations by `hamerlyAssignAndAccumulate`.
+ */
+struct HamerlyState
+{
+	/**
+	 * Index of the centroid each point is assigned to.
+	 */
+	std::vector<int> assignments;
+
+	/**
+	 * Upper bound of the distance between each point and the centroid it's assigned to.
+	 */
+	std::vector<double> upper;
+
+	/**
+	 * Lower bound of the distance between each point and its second closest centroid.
+	 */
+	std::vector<double> lower;
+
+	/**
+	 * Centroids as of the previous iteration, used to loosen bounds by how far centroids moved since. Empty before the
+	 * first iteration.
+	 */
+	std::vector<double> centroids;
+
+	/**
+	 * Number of points that were compared against every centroid during the last iteration.
+	 */
+	int scanned = 0;
+};
+
+/**
+ * Assigns each of the `points` to the closest of the `k` `centroids` into `memberships`, updating the running `sums`
+ * and `counts` of each centroid by the points whose membership changed, & adding the squared distance between each
+ * point and its centroid to `squares` if specified (see `assignAndAccumulate`). Returns the number of memberships
+ * that changed since the previous call for the same `state`.
+ *
+ * Implements Hamerly's algorithm: a point is only compared against every centroid if the upper bound of the (Euclidean)
+ * distance to its centroid exceeds both the lower bound of the distance to its second closest centroid, and half the
+ * distance between its centroid and the centroid closest to it; otherwise its membership provably can't change (and the
+ * distance to its centroid is only computed for `squares`).
+ */
+template<typename T>
+int hamerlyAssignAndAccumulate(
+	const BasicPoints<T>& points,
+	int k, const double* centroids,
+	int* memberships,
+	double* sums, double* counts, double* squares,
+	HamerlyState& state
+);
+
+#endif
@@ -0,0 +1,511 @@
+#if defined(CLUSTER_MODE_SERIAL) || defined(CLUSTER_MODE_OPENMP)
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#ifdef CLUSTER_OPENMP
+#include <omp.h>
+#endif
+
+#include "kmeans.h"
+#include "aggregate.h"
+#include "exact.h"
+#include "hamerly.h"
+#include "lloyd.h"
+#include "loader.h"
+#include "minibatch.h"
+#include "seeding.h"
+#include "sorted.h"
+#include "util.h"
+#include "warmstart.h"
+
+/**
+ * Returns the number of threads to cluster across: `omp_get_max_threads()` in the OpenMP build (see `Args::threads`),
+ * or one per core otherwise.
+ */
+int maxThreads()
+{
+#ifdef CLUSTER_OPENMP
+	return omp_get_max_threads();
+#else
+	return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+/**
+ * Executes k-means on `points` (of values of type `T`) for `args` as restart `restart`, from `initialCentroids` (if
+ * specified) or initial centroids chosen with k-means++ (seeded with `seed`), into `run`, adding the time spent in each
+ * phase to `timings` & the statistics of each iteration to `telemetry` (if specified; not for the sorted & exact
+ * algorithms). If `folded` is specified, its clusters are folded into each update of centroids. Iteration data is only
+ * output if `verbose`. The exact algorithm ignores `seed`.
+ *
+ * Memberships are assigned (& the exact algorithm runs) across `maxThreads()` threads in the OpenMP build; only the
+ * exact algorithm is threaded otherwise.
+ */
+template<typename T>
+void runKmeans(
+	const BasicPoints<T>& points, const Args& args, int restart, unsigned long seed,
+	const double* initialCentroids, const ClusterState* folded,
+	bool verbose, KMeansRun& run, Timings& timings, Telemetry* telemetry
+)
+{
+	int n = points.n;
+	int d = points.d;
+	Clock::time_point tPhase = Clock::now();
+
+	// Compute optimal clusters directly, without initial centroids nor iterations.
+	if (args.algorithm == Algorithm::Exact)
+	{
+		run.centroids.resize(args.k);
+		run.memberships.resize(n);
+		exactKmeans(
+			n, points.values, points.weights, args.k, run.centroids.data(), run.memberships.data(), maxThreads()
+		);
+		run.iterations = 1;
+		tPhase = timings.lap(Phase::Assign, tPhase);
+
+		run.inertia = computeInertia(points, run.centroids.data(), run.memberships.data());
+		timings.lap(Phase::Reduce, tPhase);
+		return;
+	}
+
+	// Calculate initial centroids with k-means++, unless specified.
+	run.centroids.resize(args.k * d);
+	double* centroids = run.centroids.data();
+
+	if (initialCentroids != nullptr)
+	{
+		std::copy(initialCentroids, initialCentroids + args.k * d, centroids);
+	}
+	else
+	{
+		std::mt19937_64 rng(seed);
+		kmeansPlusPlus(points, args.k, centroids, rng);
+	}
+
+	tPhase = timings.lap(Phase::Seed, tPhase);
+
+	// Memberships are updated in place, with changes counted as they're assigned.
+	run.memberships.assign(n, -1);
+	int* memberships = run.memberships.data();
+
+	if (args.algorithm == Algorithm::Sorted)
+	{
+		run.iterations = sortedKmeans(
+			n, points.values, points.weights, args.k, centroids, memberships, args.tolerance, args.maxIterations, verbose
+		);
+		tPhase = timings.lap(Phase::Assign, tPhase);
+
+		run.inertia = computeInertia(points, centroids, memberships);
+		timings.lap(Phase::Reduce, tPhase);
+		return;
+	}
+
+	// Running sums & counts of the members of each centroid, updated by changed memberships only; starting from the
+	// clusters folded in, if any.
+	std::vector<double> sumsBuf(args.k * d);
+	std::vector<double> countsBuf(args.k);
+	double* sums = sumsBuf.data();
+	double* counts = countsBuf.data();
+
+	if (folded != nullptr)
+		folded->fold(sums, counts);
+
+	// Running sums & counts drift by the rounding of every change, so they're periodically computed afresh.
+	auto reaccumulate = [&]()
+	{
+		accumulateMembers(points, args.k, memberships, sums, counts);
+		if (folded != nullptr)
+			folded->fold(sums, counts);
+	};
+
+	// Distance bounds (of the slice of each thread, in the OpenMP build), kept across iterations when pruning with
+	// Hamerly's algorithm.
+#ifdef CLUSTER_OPENMP
+	std::vector<HamerlyState> hamerly(omp_get_max_threads());
+#else
+	HamerlyState hamerly;
+#endif
+
+	// Centroids the points were assigned to, & the squared distances to them, from which telemetry derives inertia.
+	std::vector<double> previous;
+	double squaresBuf;
+	double* squares = telemetry != nullptr ? &squaresBuf : nullptr;
+
+	int iterations = 0;
+	int changed;
+	double shift;
+	double maxShift;
+
+	do
+	{
+		++iterations;
+		Clock::time_point tIteration = tPhase;
+
+		if (telemetry != nullptr)
+		{
+			previous.assign(centroids, centroids + args.k * d);
+			squaresBuf = folded != nullptr ? folded->squaredDistances(centroids) : 0;
+		}
+
+		// Populate memberships & accumulate members of each centroid in a single pass, then recalculate centroids
+#ifdef CLUSTER_OPENMP
+		changed = parallelAssignAndAccumulate(
+			points, args.k, centroids, memberships, sums, counts, squares,
+			args.algorithm == Algorithm::Hamerly ? &hamerly : nullptr
+		);
+#else
+		if (args.algorithm == Algorithm::Hamerly)
+		{
+			changed = hamerlyAssignAndAccumulate(
+				points, args.k, centroids, memberships, sums, counts, squares, hamerly
+			);
+		}
+		else
+		{
+			changed = assignAndAccumulate(points, args.k, centroids, memberships, sums, counts, squares);
+		}
+#endif
+
+		tPhase = timings.lap(Phase::Assign, tPhase);
+
+		if (iterations % REACCUMULATE_INTERVAL == 0)
+			reaccumulate();
+
+		shift = updateCentroids(args.k, d, sums, counts, centroids, &maxShift);
+		tPhase = timings.lap(Phase::Reduce, tPhase);
+
+		if (telemetry != nullptr)
+		{
+			long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tPhase - tIteration).count();
+			double inertia = telemetry->inertia(args.k, d, previous.data(), sums, counts, squaresBuf);
+			telemetry->record({ 0, restart, iterations, inertia, (double)changed, maxShift, ns, 0, 0 });
+		}
+
+		// Output iteration data
+		if (verbose)
+		{
+			std::cout << "centroids = ";
+			printArr(args.k * d, centroids);
+			std::cout << "\nchanged = " << changed << "\nshift = " << shift << std::endl;
+
+#ifndef CLUSTER_OPENMP
+			if (args.algorithm == Algorithm::Hamerly)
+				std::cout << "scanned = " << hamerly.scanned << std::endl;
+#endif
+
+			std::cout << "memberships = ";
+			printArr(n, memberships);
+
+			std::cout << '\n' << std::endl;
+		}
+	}
+	while (!hasConverged(iterations, changed, shift, args.tolerance, args.maxIterations));
+
+	// The final centroids are the means of their members as accumulated afresh, independent of the changes.
+	reaccumulate();
+	updateCentroids(args.k, d, sums, counts, centroids);
+
+	run.iterations = iterations;
+	run.inertia = computeInertia(points, centroids, memberships);
+	timings.lap(Phase::Reduce, tPhase);
+}
+
+int initialize(const Args&, bool& isRoot)
+{
+	isRoot = true;
+	return 0;
+}
+
+void finalize()
+{
+}
+
+/**
+ * Executes `kmeans` for `args`, clustering values of type `T`.
+ */
+template<typename T>
+KMeansResult typedKmeans(const Args& args)
+{
+	// Retrieve points from input file, parsing text across as many threads as used for clustering
+	Timings timings;
+	Clock::time_point tPhase = Clock::now();
+
+	Dataset dataset;
+	if (!loadPoints(args.inputFile, dataset, maxThreads()))
+		return { -9 };
+
+	timings.lap(Phase::Load, tPhase);
+
+	Points points = dataset.points();
+	int n = points.n;
+	int d = points.d;
+
+	if (n == 0)
+	{
+		std::cerr << "No values to cluster." << std::endl;
+		return { -3 };
+	}
+
+	if (args.k <= 0)
+	{
+		std::cerr << "K must be positive." << std::endl;
+		return { -4 };
+	}
+
+	if (args.k > n)
+	{
+		std::cerr << "K must be less than the number of values to cluster." << std::endl;
+		return { -5 };
+	}
+
+	if ((args.algorithm == Algorithm::Sorted || args.algorithm == Algorithm::Exact) && d != 1)
+	{
+		std::cerr << "The sorted & exact algorithms only support 1-dimensional values." << std::endl;
+		return { -11 };
+	}
+
+	if (args.aggregation != Aggregation::None && d != 1)
+	{
+		std::cerr << "Aggregation only supports 1-dimensional values." << std::endl;
+		return { -16 };
+	}
+
+	// Resume from the state of previous runs, if any, clustering only the values appended since.
+	ClusterState state;
+	state.k = args.k;
+	state.d = d;
+	int hasState = args.stateFile != nullptr ? loadState(args.stateFile, state) : 0;
+
+	if (hasState < 0)
+		return { -19 };
+
+	if (hasState > 0)
+	{
+		if (state.k != args.k || state.n > n)
+		{
+			std::cerr << args.stateFile << ": The state holds " << state.k << " clusters of " << state.n
+				<< " values, but " << args.k << " clusters of up to " << n << " values are expected." << std::endl;
+			return { -19 };
+		}
+
+		points = points.slice(state.n, n - state.n);
+		n = points.n;
+
+		if (n == 0)
+		{
+			std::cerr << "No new values to cluster." << std::endl;
+			return { -3 };
+		}
+	}
+	else
+	{
+		state.counts.assign(args.k, 0);
+	}
+
+	std::vector<double> initialCentroids;
+	if (hasState > 0)
+	{
+		initialCentroids = state.centroids;
+	}
+	else if (args.initialCentroidsFile != nullptr)
+	{
+		if (!loadCentroids(args.initialCentroidsFile, args.k, d, initialCentroids))
+			return { -19 };
+	}
+
+	bool isWarm = !initialCentroids.empty();
+	if (isWarm && args.algorithm != Algorithm::Lloyd && args.algorithm != Algorithm::Hamerly)
+	{
+		std::cerr << "Initial centroids & incremental runs are only supported by the lloyd & hamerly algorithms."
+			<< std::endl;
+		return { -19 };
+	}
+
+	// Restarts of the exact algorithm, or from the same initial centroids, would only find the same clusters again.
+	int restarts = (args.algorithm == Algorithm::Exact || isWarm) ? 1 : std::max(1, args.restarts);
+
+	std::cout << "n = " << n << std::endl;
+	std::cout << "d = " << d << std::endl;
+	std::cout << "k = " << args.k << std::endl;
+
+#ifdef CLUSTER_OPENMP
+	std::cout << "threads = " << omp_get_max_threads() << std::endl;
+#endif
+
+	std::cout << "restarts = " << restarts << std::endl;
+
+	if (hasState > 0)
+		std::cout << "folded = " << state.n << std::endl;
+
+	if (args.verbose)
+	{
+		for (int j = 0; j < d; j++)
+		{
+			std::cout << "arr[" << j << "] = ";
+			printArr(n, points.dim(j));
+			std::cout << '\n';
+		}
+		std::cout << std::endl;
+	}
+
+	// Collapse values into weighted values, if requested, & cluster those instead; memberships are expanded back to
+	// every value once clustered.
+	tPhase = Clock::now();
+	Aggregate aggregate;
+	Points clustered = points;
+
+	if (args.aggregation != Aggregation::None)
+	{
+		aggregatePoints(points, args.aggregation, args.bins, aggregate);
+		clustered = aggregate.points();
+		std::cout << "aggregated = " << clustered.n << std::endl;
+
+		if (args.k > clustered.n && !isWarm)
+		{
+			std::cerr << "K must be less than the number of aggregated values to cluster." << std::endl;
+			return { -5 };
+		}
+	}
+
+	tPhase = timings.lap(Phase::Aggregate, tPhase);
+
+	// Convert the values to cluster to the precision of computations, copying them only if single precision.
+	std::vector<T> convertedValues;
+	BasicPoints<T> converted = convertPoints(clustered, convertedValues);
+	timings.lap(Phase::Load, tPhase);
+
+	// Run restarts concurrently across threads, all sharing the same points; each thread keeps the best of its runs. In
+	// the OpenMP build, the threads of each restart's parallel regions are split evenly across concurrent restarts.
+	int threads = maxThreads();
+	int concurrent = std::min(restarts, threads);
+	unsigned long seed = rand();
+
+	std::vector<KMeansRun> best(concurrent);
+	std::vector<Timings> threadTimings(concurrent);
+
+	// Statistics of each iteration are recorded per thread, & combined once every thread is done. Their inertia
+	// accounts for the distances between the original values & the weighted values of bins standing for them.
+	Telemetry telemetry;
+	telemetry.residual = aggregate.residual;
+
+	std::vector<Telemetry> threadTelemetry(concurrent, telemetry);
+	std::atomic<int> nextRestart(0);
+
+	auto runRestarts = [&](int thread)
+	{
+#ifdef CLUSTER_OPENMP
+		omp_set_num_threads(std::max(1, threads / concurrent));
+#endif
+
+		KMeansRun run;
+		for (int r = nextRestart++; r < restarts; r = nextRestart++)
+		{
+			bool verbose = args.verbose && restarts == 1;
+			Telemetry* runTelemetry = args.telemetryOutputFile != nullptr ? &threadTelemetry[thread] : nullptr;
+			runKmeans(
+				converted, args, r, seed + r, isWarm ? initialCentroids.data() : nullptr,
+				hasState > 0 ? &state : nullptr, verbose, run, threadTimings[thread], runTelemetry
+			);
+			if (run.inertia < best[thread].inertia)
+				std::swap(run, best[thread]);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int t = 1; t < concurrent; t++)
+		pool.emplace_back(runRestarts, t);
+
+	runRestarts(0);
+	for (std::thread& t : pool)
+		t.join();
+
+#ifdef CLUSTER_OPENMP
+	omp_set_num_threads(threads);
+#endif
+
+	for (const Timings& t : threadTimings)
+		timings.add(t);
+
+	for (const Telemetry& t : threadTelemetry)
+		telemetry.lines += t.lines;
+
+	KMeansRun& run = *std::min_element(
+		best.begin(), best.end(), [](const KMeansRun& l, const KMeansRun& r) { return l.inertia < r.inertia; }
+	);
+
+	std::cout << "iterations = " << run.iterations << std::endl;
+
+	// Expand memberships of the weighted values back to every value, & account for the inertia lost to bins
+	if (args.aggregation != Aggregation::None)
+	{
+		tPhase = Clock::now();
+		std::vector<int> memberships(n);
+		aggregate.expand(points, run.memberships.data(), memberships.data());
+		std::swap(memberships, run.memberships);
+		run.inertia += aggregate.residual;
+		timings.lap(Phase::Aggregate, tPhase);
+	}
+
+	// Score the clusters of every value, if requested.
+	QualityScores scores;
+	if (args.quality)
+	{
+		tPhase = Clock::now();
+		scores = scoreClusters(points, args.k, run.centroids.data(), run.memberships.data(), threads);
+		timings.lap(Phase::Score, tPhase);
+	}
+
+	// Fold the new values into the state of clusters, for the next run to resume from.
+	if (args.stateFile != nullptr)
+		state.add(points, run.memberships.data(), run.centroids.data(), run.inertia);
+
+	return {
+		0, true, n, d, std::move(run.memberships), std::move(run.centroids), timings, run.inertia, telemetry,
+		std::move(state), scores
+	};
+}
+
+KMeansResult kmeans(Args args)
+{
+#ifdef CLUSTER_OPENMP
+	if (args.threads > 0)
+		omp_set_num_threads(args.threads);
+#endif
+
+	// Stream points from the input file when using mini-batch k-means, rather than reading them into memory
+	if (args.algorithm == Algorithm::MiniBatch)
+	{
+		if (args.aggregation != Aggregation::None)
+		{
+			std::cerr << "Aggregation isn't supported by the minibatch algorithm." << std::endl;
+			return { -16 };
+		}
+
+		if (args.precision != Precision::Double)
+		{
+			std::cerr << "Single precision isn't supported by the minibatch algorithm." << std::endl;
+			return { -17 };
+		}
+
+		if (args.initialCentroidsFile != nullptr || args.stateFile != nullptr)
+		{
+			std::cerr << "Initial centroids & incremental runs aren't supported by the minibatch algorithm."
+				<< std::endl;
+			return { -19 };
+		}
+
+		if (args.quality)
+		{
+			std::cerr << "Quality scores aren't supported by the minibatch algorithm." << std::endl;
+			return { -21 };
+		}
+
+		return minibatchKmeans(args);
+	}
+
+	return args.precision == Precision::Single ? typedKmeans<float>(args) : typedKmeans<double>(args);
+}
+
+#endif
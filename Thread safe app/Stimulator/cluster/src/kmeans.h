@@ -2,9 +2,14 @@
 #define KMEANS_H
 
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #include "Args.h"
+#include "quality.h"
+#include "telemetry.h"
+#include "timings.h"
+#include "warmstart.h"
 
 /**
  * Result of executing `kmeans`.
@@ -23,26 +28,99 @@ struct KMeansResult
 	bool isRoot = true;
 
 	/**
-	 * Number of values clustered.
+	 * Number of values clustered; may exceed `INT_MAX` when streamed (by minibatch).
 	 */
-	int n = -1;
+	long n = -1;
 
 	/**
-	 * Array of memberships of each value.
+	 * Number of dimensions of each value.
 	 */
-	int* memberships = nullptr;
+	int d = 1;
 
 	/**
-	 * Array of centroid values.
+	 * Memberships of each value; empty if already written to `Args::membershipOutputFile` while clustering (by
+	 * minibatch, and the MPI builds).
 	 */
-	double* centroids = nullptr;
+	std::vector<int> memberships = {};
+
+	/**
+	 * Centroid values; `d` consecutive values per centroid.
+	 */
+	std::vector<double> centroids = {};
+
+	/**
+	 * Time spent in each phase of `kmeans`; on the root, the slowest node of each phase (when distributed).
+	 */
+	Timings timings = {};
+
+	/**
+	 * Sum of the squared distances between each value and the centroid it's a member of; negative if not computed.
+	 */
+	double inertia = -1;
+
+	/**
+	 * Statistics of each iteration, if `Args::telemetryOutputFile` is specified; on the root, of every restart (when
+	 * distributed).
+	 */
+	Telemetry telemetry = {};
+
+	/**
+	 * State of clusters once the values of this run are folded into it, if `Args::stateFile` is specified.
+	 */
+	ClusterState state = {};
+
+	/**
+	 * Scores of the quality of the clusters, if `Args::quality` is specified.
+	 */
+	QualityScores scores = {};
+};
+
+/**
+ * Solution found by a single run of k-means, among several restarts from different initial centroids.
+ */
+struct KMeansRun
+{
+	/**
+	 * Memberships of each value.
+	 */
+	std::vector<int> memberships;
+
+	/**
+	 * Centroid values; `d` consecutive values per centroid.
+	 */
+	std::vector<double> centroids;
+
+	/**
+	 * Number of iterations executed.
+	 */
+	int iterations = 0;
+
+	/**
+	 * Sum of the squared distances between each value and the centroid it's a member of; infinite until run, such that
+	 * any run is better.
+	 */
+	double inertia = std::numeric_limits<double>::infinity();
 };
 
 /**
- * Executes the k-means clustering algorithm for `args`, on the values of `arr`, populating `newMemberships` and
- * `centroids` (both expected to be initialized) in the process.
+ * Initializes state kept across calls of `kmeans` for the lifetime of the process: MPI in the MPI builds, and the
+ * OpenCL device, context & program in the OpenCL build. Sets `isRoot` to whether this process reports results (i.e.
+ * the root, when distributed).
  *
- * If distributing with MPI, the implementation is expected to init & finalize MPI processes.
+ * Must be called (by every process, when distributed) before `kmeans`; returns 0 if initialized, or a negative error
+ * code otherwise.
+ */
+int initialize(const Args& args, bool& isRoot);
+
+/**
+ * Releases the state initialized by `initialize`; must be called once done with `kmeans`, even if `initialize`
+ * failed.
+ */
+void finalize();
+
+/**
+ * Executes the k-means clustering algorithm for `args`, on the values read from `args.inputFile`. May be called any
+ * number of times between `initialize` and `finalize`, e.g. for each job of a batch.
  */
 KMeansResult kmeans(Args args);
 
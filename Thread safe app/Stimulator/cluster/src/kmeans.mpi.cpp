@@ -0,0 +1,496 @@
+#if defined(CLUSTER_MODE_MPI_SERIAL) || defined(CLUSTER_MODE_MPI_OPENMP)
+
+#include <algorithm>
+#include <math.h>
+#include <mpich/mpi.h>
+
+#ifdef CLUSTER_OPENMP
+#include <omp.h>
+#endif
+
+#include "kmeans.h"
+#include "aggregate.h"
+#include "balance.h"
+#include "hamerly.h"
+#include "lloyd.h"
+#include "loader.h"
+#include "restarts.h"
+#include "seeding.h"
+#include "util.h"
+#include "warmstart.h"
+#include "writer.h"
+
+std::ostream& log()
+{
+	static int mpiRank = -1;
+	if (mpiRank == -1)
+		MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+	std::cout << mpiRank << ": ";
+	return std::cout;
+}
+
+int initialize(const Args&, bool& isRoot)
+{
+#ifdef CLUSTER_OPENMP
+	// Only the main thread makes MPI calls; the threads of each node only run between them.
+	int provided;
+	MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
+#else
+	MPI_Init(nullptr, nullptr);
+#endif
+
+	int mpiRank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+	isRoot = (mpiRank == 0);
+
+	return 0;
+}
+
+void finalize()
+{
+	MPI_Finalize();
+}
+
+/**
+ * Executes `kmeans` for `args`, clustering values of type `T`.
+ */
+template<typename T>
+KMeansResult typedKmeans(const Args& args)
+{
+	// Retrieve MPI rank & size
+	int mpiRank;
+	int mpiSize;
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+	MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+	bool isRoot = (mpiRank == 0);
+
+	if (args.algorithm == Algorithm::Sorted || args.algorithm == Algorithm::MiniBatch)
+	{
+		if (isRoot)
+		{
+			std::cerr << "The sorted & minibatch algorithms are only supported by the serial & OpenMP builds."
+				<< std::endl;
+		}
+
+		return { -10, isRoot };
+	}
+
+	if (args.algorithm == Algorithm::Exact)
+	{
+		if (isRoot)
+			std::cerr << "The exact algorithm is only supported by the serial & OpenMP builds." << std::endl;
+
+		return { -10, isRoot };
+	}
+
+	if (args.stateFile != nullptr)
+	{
+		if (isRoot)
+			std::cerr << "Incremental runs are only supported by the serial & OpenMP builds." << std::endl;
+
+		return { -10, isRoot };
+	}
+
+#ifdef CLUSTER_OPENMP
+	// Values are clustered across threads within each node, so a single node per machine suffices.
+	if (args.threads > 0)
+		omp_set_num_threads(args.threads);
+#endif
+
+	// Restarts from the same initial centroids would only find the same clusters again.
+	int restarts = args.initialCentroidsFile != nullptr ? 1 : std::max(1, args.restarts);
+
+	// Split nodes into groups, each running its share of restarts concurrently with the others
+	MPI_Comm group;
+	MPI_Comm roots;
+	int groups;
+	int groupIndex = splitRestarts(restarts, group, roots, groups);
+
+	int groupRank;
+	MPI_Comm_rank(group, &groupRank);
+
+	// Retrieve points from input file, partitioned across the nodes of each group
+	std::vector<double> values;
+	std::vector<int> counts;
+	std::vector<int> displacements;
+	int n;
+	int d;
+	Timings timings;
+
+	if (!loadPartition(args.inputFile, group, roots, args.verbose, values, n, d, counts, displacements, timings))
+	{
+		freeRestarts(group, roots);
+		return { -9, isRoot };
+	}
+
+	if (n == 0 || args.k <= 0 || args.k > n)
+	{
+		if (isRoot)
+			std::cerr << "K must be positive, and less than the number of values to cluster." << std::endl;
+
+		freeRestarts(group, roots);
+		return { -4, isRoot };
+	}
+
+	if (args.aggregation != Aggregation::None && d != 1)
+	{
+		if (isRoot)
+			std::cerr << "Aggregation only supports 1-dimensional values." << std::endl;
+
+		freeRestarts(group, roots);
+		return { -16, isRoot };
+	}
+
+	if (args.rebalance > 0 && args.aggregation != Aggregation::None)
+	{
+		if (isRoot)
+			std::cerr << "Rebalancing isn't supported with aggregation." << std::endl;
+
+		freeRestarts(group, roots);
+		return { -18, isRoot };
+	}
+
+	// Start every restart from the specified initial centroids, if any, read by the root.
+	std::vector<double> initialCentroids;
+	if (args.initialCentroidsFile != nullptr
+		&& !loadCentroidsParallel(args.initialCentroidsFile, MPI_COMM_WORLD, args.k, d, initialCentroids))
+	{
+		freeRestarts(group, roots);
+		return { -19, isRoot };
+	}
+
+	if (isRoot)
+	{
+		std::cout << "n = " << n << std::endl;
+		std::cout << "d = " << d << std::endl;
+		std::cout << "k = " << args.k << std::endl;
+
+#ifdef CLUSTER_OPENMP
+		std::cout << "threads = " << omp_get_max_threads() << std::endl;
+#endif
+
+		std::cout << "restarts = " << restarts << std::endl;
+	}
+
+	int localN = counts[groupRank];
+	Points points = { localN, d, localN, values.data() };
+
+	// Collapse local values into weighted values, if requested, & cluster those instead; memberships are expanded back
+	// to every local value once clustered.
+	Clock::time_point tPhase = Clock::now();
+	Aggregate aggregate;
+	Points clustered = points;
+
+	if (args.aggregation != Aggregation::None)
+	{
+		aggregatePartition(points, args.aggregation, args.bins, group, aggregate);
+		clustered = aggregate.points();
+
+		int aggregatedN = clustered.n;
+		MPI_Allreduce(MPI_IN_PLACE, &aggregatedN, 1, MPI_INT, MPI_SUM, group);
+		if (isRoot)
+			std::cout << "aggregated = " << aggregatedN << std::endl;
+	}
+
+	tPhase = timings.lap(Phase::Aggregate, tPhase);
+
+	// Convert the values to cluster to the precision of computations, copying them only if single precision.
+	std::vector<T> convertedValues;
+	BasicPoints<T> converted = convertPoints(clustered, convertedValues);
+	tPhase = timings.lap(Phase::Load, tPhase);
+
+	// Local memberships of the current & best run of the group, swapped whenever the current run is better.
+	std::vector<int> memberships(clustered.n);
+	std::vector<int> bestMemberships(clustered.n);
+
+	// Running sums & counts of the members of each centroid across the group, updated by the changes of each iteration:
+	// those of the local sums & counts, followed by the number of changed memberships & the squared distances of values
+	// to their centroids (for telemetry), laid out contiguously so that they're combined across the nodes of the group
+	// with a single reduction.
+	std::vector<double> totals(args.k * d + args.k);
+	double* sums = totals.data();
+	double* centroidCounts = totals.data() + args.k * d;
+
+	std::vector<double> reductionValues(args.k * d + args.k + 2);
+	double* reduction = reductionValues.data();
+	double* sumChanges = reduction;
+	double* countChanges = reduction + args.k * d;
+	double& changed = reduction[args.k * d + args.k];
+	double& squared = reduction[args.k * d + args.k + 1];
+
+	// Seed restarts from the root, such that each runs from different initial centroids.
+	unsigned long seed = rand();
+	MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+
+	KMeansRun best;
+	std::vector<double> centroidValues(args.k * d);
+	double* centroids = centroidValues.data();
+
+	// Statistics of each iteration are recorded by every node, & gathered on the root once every group is done; with
+	// the bytes each node communicated since its previous iteration, i.e. seeding, the reduction & rebalancing.
+	Telemetry telemetry;
+	bool recording = (args.telemetryOutputFile != nullptr);
+	double* squares = recording ? &squared : nullptr;
+	Traffic traffic;
+	Traffic recorded;
+	std::vector<double> previous;
+
+	if (recording)
+	{
+		telemetry.residual = aggregate.residual;
+		MPI_Allreduce(MPI_IN_PLACE, &telemetry.residual, 1, MPI_DOUBLE, MPI_SUM, group);
+	}
+
+	tPhase = Clock::now();
+
+	for (int r = groupIndex; r < restarts; r += groups)
+	{
+		// Calculate initial centroids with k-means|| across the nodes of the group, unless specified
+		if (!initialCentroids.empty())
+			std::copy(initialCentroids.begin(), initialCentroids.end(), centroids);
+		else
+			kmeansParallel(converted, args.k, centroids, group, seed + r, &traffic);
+		std::fill(memberships.begin(), memberships.end(), -1);
+		std::fill(totals.begin(), totals.end(), 0.0);
+		tPhase = timings.lap(Phase::Seed, tPhase);
+
+		// Distance bounds of local values (of the slice of each thread, in the OpenMP build), kept across iterations
+		// when pruning with Hamerly's algorithm.
+#ifdef CLUSTER_OPENMP
+		std::vector<HamerlyState> hamerly(omp_get_max_threads());
+#else
+		HamerlyState hamerly;
+#endif
+
+		int iterations = 0;
+		double shift;
+		double maxShift;
+
+		do
+		{
+			++iterations;
+			Clock::time_point tIteration = tPhase;
+
+			// Compute local memberships, & the changes of local sums & counts (across threads, in the OpenMP build)
+			std::fill(reduction, reduction + args.k * d + args.k + 2, 0.0);
+			if (recording)
+				previous.assign(centroids, centroids + args.k * d);
+
+#ifdef CLUSTER_OPENMP
+			changed = parallelAssignAndAccumulate(
+				converted, args.k, centroids, memberships.data(), sumChanges, countChanges, squares,
+				args.algorithm == Algorithm::Hamerly ? &hamerly : nullptr
+			);
+#else
+			if (args.algorithm == Algorithm::Hamerly)
+			{
+				changed = hamerlyAssignAndAccumulate(
+					converted, args.k, centroids, memberships.data(), sumChanges, countChanges, squares, hamerly
+				);
+			}
+			else
+			{
+				changed = assignAndAccumulate(
+					converted, args.k, centroids, memberships.data(), sumChanges, countChanges, squares
+				);
+			}
+#endif
+
+			// Every so often, reduce the local sums & counts accumulated afresh instead of their changes, replacing the
+			// running ones (which drift by the rounding of every change).
+			bool isReaccumulating = (iterations % REACCUMULATE_INTERVAL == 0);
+			if (isReaccumulating)
+				accumulateMembers(converted, args.k, memberships.data(), sumChanges, countChanges);
+
+			tPhase = timings.lap(Phase::Assign, tPhase);
+
+			// Combine changes across nodes into the running sums & counts, and recompute centroids on each node
+			MPI_Allreduce(MPI_IN_PLACE, reduction, args.k * d + args.k + 2, MPI_DOUBLE, MPI_SUM, group);
+			traffic.allreduce(group, sizeof(double) * (args.k * d + args.k + 2));
+			for (int i = 0; i < args.k * d + args.k; i++)
+				totals[i] = isReaccumulating ? reduction[i] : totals[i] + reduction[i];
+
+			shift = updateCentroids(args.k, d, sums, centroidCounts, centroids, &maxShift);
+
+			// Output iteration data
+			if (isRoot && args.verbose && restarts == 1)
+			{
+				std::cout << "centroids = ";
+				printArr(args.k * d, centroids);
+				std::cout << "\nchanged = " << changed << "\nshift = " << shift << '\n' << std::endl;
+			}
+
+			tPhase = timings.lap(Phase::Reduce, tPhase);
+			long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tPhase - tIteration).count();
+
+			// Once the first iterations of the group's first run are timed, repartition values in proportion to the
+			// throughput of each node; memberships & distance bounds move along with their values (the latter joined
+			// across threads & split again over the new slices of each thread, in the OpenMP build).
+			bool isRebalancing = (args.rebalance > 0 && r == groupIndex && iterations == args.rebalance);
+			std::vector<double> weights;
+
+			if (isRebalancing)
+			{
+				std::vector<int> fromCounts = counts;
+				std::vector<int> fromDisplacements = displacements;
+
+				if (balancePartition(timings[Phase::Assign], group, counts, displacements, weights, &traffic))
+				{
+					redistribute(values, d, fromCounts, fromDisplacements, counts, displacements, group, &traffic);
+					redistribute(
+						memberships, 1, fromCounts, fromDisplacements, counts, displacements, group, &traffic
+					);
+
+					if (args.algorithm == Algorithm::Hamerly)
+					{
+#ifdef CLUSTER_OPENMP
+						HamerlyState moved;
+						joinHamerlyStates(hamerly, moved);
+#else
+						HamerlyState& moved = hamerly;
+#endif
+						redistribute(
+							moved.assignments, 1, fromCounts, fromDisplacements, counts, displacements, group, &traffic
+						);
+						redistribute(
+							moved.upper, 1, fromCounts, fromDisplacements, counts, displacements, group, &traffic
+						);
+						redistribute(
+							moved.lower, 1, fromCounts, fromDisplacements, counts, displacements, group, &traffic
+						);
+#ifdef CLUSTER_OPENMP
+						splitHamerlyState(moved, hamerly);
+#endif
+					}
+
+					localN = counts[groupRank];
+					points = { localN, d, localN, values.data() };
+					clustered = points;
+					converted = convertPoints(clustered, convertedValues);
+					bestMemberships.resize(localN);
+				}
+
+				if (isRoot)
+				{
+					std::cout << "weights = ";
+					printArr(weights.size(), weights.data());
+					std::cout << std::endl;
+				}
+
+				tPhase = timings.lap(Phase::Scatter, tPhase);
+			}
+
+			if (recording)
+			{
+				double inertia = telemetry.inertia(args.k, d, previous.data(), sums, centroidCounts, squared);
+				long sent = traffic.sent - recorded.sent;
+				long received = traffic.received - recorded.received;
+				telemetry.record({ mpiRank, r, iterations, inertia, changed, maxShift, ns, sent, received });
+				recorded = traffic;
+
+				if (isRebalancing && groupRank == 0)
+					telemetry.recordPartition(r, iterations, weights, counts);
+			}
+		}
+		while (!hasConverged(iterations, changed, shift, args.tolerance, args.maxIterations));
+
+		// The final centroids are the means of their members as accumulated afresh, independent of the changes
+		accumulateMembers(converted, args.k, memberships.data(), sums, centroidCounts);
+		MPI_Allreduce(MPI_IN_PLACE, totals.data(), args.k * d + args.k, MPI_DOUBLE, MPI_SUM, group);
+		updateCentroids(args.k, d, sums, centroidCounts, centroids);
+
+		// Keep the run if it's the best of the group so far
+		double inertia = computeInertia(converted, centroids, memberships.data()) + aggregate.residual;
+		MPI_Allreduce(MPI_IN_PLACE, &inertia, 1, MPI_DOUBLE, MPI_SUM, group);
+
+		if (inertia < best.inertia)
+		{
+			best.inertia = inertia;
+			best.iterations = iterations;
+			best.centroids.assign(centroids, centroids + args.k * d);
+			std::swap(memberships, bestMemberships);
+		}
+
+		tPhase = timings.lap(Phase::Reduce, tPhase);
+	}
+
+	// Find the group that found the best run, whose nodes write its memberships, & select its centroids on the root
+	struct { double inertia; int index; } bestGroup = { best.inertia, groupIndex };
+	MPI_Allreduce(MPI_IN_PLACE, &bestGroup, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
+
+	if (roots != MPI_COMM_NULL)
+		selectBestRun(best, 0, args.k * d, roots);
+
+	if (recording)
+		gatherTelemetry(telemetry, MPI_COMM_WORLD);
+
+	tPhase = timings.lap(Phase::Gather, tPhase);
+
+	// Expand memberships of the best run's weighted values back to every local value, where they're scored or written
+	bool isBest = (groupIndex == bestGroup.index);
+	if (isBest && args.aggregation != Aggregation::None && (args.quality || args.membershipOutputFile != nullptr))
+	{
+		memberships.resize(localN);
+		aggregate.expand(points, bestMemberships.data(), memberships.data());
+		std::swap(memberships, bestMemberships);
+		tPhase = timings.lap(Phase::Aggregate, tPhase);
+	}
+
+	// Score the clusters of the best run across every node, of which only those of its group hold values
+	QualityScores scores;
+	if (args.quality)
+	{
+		Points scored = isBest ? points : Points{ 0, d, 0, nullptr };
+#ifdef CLUSTER_OPENMP
+		int threads = omp_get_max_threads();
+#else
+		int threads = 1;
+#endif
+		scores = scoreClustersParallel(
+			scored, args.k, best.centroids.data(), bestMemberships.data(), threads, MPI_COMM_WORLD
+		);
+		tPhase = timings.lap(Phase::Score, tPhase);
+	}
+
+	// Write memberships of the best run directly from the nodes of its group, rather than gathering them on the root
+	if (args.membershipOutputFile != nullptr)
+	{
+		int written = 1;
+		if (isBest)
+		{
+			written = writeMembershipsParallel(
+				args.membershipOutputFile, group, localN, bestMemberships.data(), args.outputFormat
+			);
+		}
+
+		MPI_Allreduce(MPI_IN_PLACE, &written, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+		if (!written)
+		{
+			freeRestarts(group, roots);
+			return { -6, isRoot };
+		}
+
+		if (isRoot)
+			std::cout << "Wrote memberships to " << args.membershipOutputFile << std::endl;
+
+		timings.lap(Phase::Write, tPhase);
+	}
+
+	freeRestarts(group, roots);
+
+	if (isRoot)
+		std::cout << "iterations = " << best.iterations << std::endl;
+
+	// Report the time of the slowest node in each phase
+	MPI_Reduce(isRoot ? MPI_IN_PLACE : timings.ns, timings.ns, PHASE_COUNT, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	return { 0, isRoot, n, d, {}, std::move(best.centroids), timings, best.inertia, telemetry, {}, scores };
+}
+
+KMeansResult kmeans(Args args)
+{
+	return args.precision == Precision::Single ? typedKmeans<float>(args) : typedKmeans<double>(args);
+}
+
+#endif
@@ -1,60 +1,218 @@
 /**
- * Returns the absolute value of the specified `double`.
+ * Type of the values clustered, & in which distances are computed on the device; defined by the host when
+ * building the program (`-D VALUE_TYPE=float` for single precision, which needs no `cl_khr_fp64` support), and double
+ * precision otherwise.
  */
-double absd(double d)
-{
-	return (d < 0) ? -d : d;
-}
+#ifndef VALUE_TYPE
+#define VALUE_TYPE double
+#endif
+
+typedef VALUE_TYPE real;
+
+/**
+ * Type in which sums of values & squared distances are accumulated; defined by the host as double wherever the device
+ * supports double precision (even for single precision values), & float otherwise. Counts (of weights, which are
+ * integers) & numbers of changes are accumulated as integers either way, so they stay exact.
+ */
+#ifndef ACC_TYPE
+#define ACC_TYPE double
+#endif
+
+typedef ACC_TYPE acc;
 
 /**
- * Computes the index of the element within `centroids` (of length `_k`) to which the element at `global_id(0)` of `arr`
- * is closest, into `memberships`.
+ * Computes the index of the element within `centroids` (`_k` points of `_d` dimensions, stored consecutively) to which
+ * the point at `global_id(0)` of `arr` is closest, into `memberships`, keeping its previous membership in `previous` &
+ * the squared distance to the closest in `distances`. `arr` holds `_n` points as a structure of arrays, i.e.
+ * coordinate `j` of point `i` is at `arr[j * _n + i]`.
  */
 kernel void computeLocalMemberships(
 	global int* _k,
-	global double* arr,
-	global double* centroids,
-	global int* memberships
+	global int* _n,
+	global int* _d,
+	global real* arr,
+	global real* centroids,
+	global int* memberships,
+	global int* previous,
+	global real* distances
 ) {
-	int n = get_global_id(0);
+	int i = get_global_id(0);
 	int k = *_k;
+	int n = *_n;
+	int d = *_d;
 
 	int minIdx = 0;
-	double minDiff = absd(centroids[0] - arr[n]);
+	real minDiff = INFINITY;
+
+	for (int c = 0; c < k; c++)
+	{
+		real diff = 0;
+		for (int j = 0; j < d; j++)
+		{
+			real delta = arr[j * n + i] - centroids[c * d + j];
+			diff += delta * delta;
+		}
+
+		if (diff < minDiff)
+		{
+			minIdx = c;
+			minDiff = diff;
+		}
+	}
+
+	previous[i] = memberships[i];
+	memberships[i] = minIdx;
+	distances[i] = minDiff;
+}
+
+/**
+ * Sums each of the `rows` rows of `local_size(0)` values of `scratch`, & the row of `local_size(0)` values of
+ * `tallies`, into the first value of the row, with a tree reduction across the work-items of the workgroup.
+ * `local_size(0)` must be a power of two.
+ */
+void reduceLocal(local acc* scratch, int rows, local long* tallies)
+{
+	int lid = get_local_id(0);
+	int size = get_local_size(0);
 
-	for (int i = 0; i < k; i++)
+	for (int s = size / 2; s > 0; s /= 2)
 	{
-		if (absd(centroids[i] - arr[n]) < minDiff)
-			minIdx = i;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		if (lid < s)
+		{
+			for (int r = 0; r < rows; r++)
+				scratch[r * size + lid] += scratch[r * size + lid + s];
+			tallies[lid] += tallies[lid + s];
+		}
 	}
 
-	memberships[n] = minIdx;
+	barrier(CLK_LOCAL_MEM_FENCE);
 }
 
 /**
- * Recomputes the element at `global_id(0)` of `centroids`, according to the `memberships` of elements of `arr` (both of
- * length `_n`).
+ * Computes the partial changes of the sums & counts of the members of each of the `_k` centroids among the points of
+ * `arr` (`_n` points of `_d` dimensions, stored as a structure of arrays), the number of changed memberships & the sum
+ * of the squared `distances` of points to their centroids, over the points strided across the workgroup at
+ * `group_id(0)`: each point whose membership changed from `previous` to `memberships` is subtracted from its previous
+ * centroid (unless -1) & added to its new one, while the values of other points aren't read. If `weights` isn't null,
+ * each point is weighted by its (integer) weight; i.e. counts are total weights, & sums & distances are weighted.
+ *
+ * The partials of each workgroup are written consecutively to `partials`, laid out as `_k * _d` sums & the sum of
+ * distances, & to `tallies`, laid out as `_k` counts & the number of changes. `scratch` must hold `_d` values per
+ * work-item, & `tallyScratch` one.
  */
-kernel void recomputeCentroids(
+kernel void accumulatePartials(
+	global int* _k,
 	global int* _n,
-	global double* arr,
-	global double* centroids,
-	global int* memberships
+	global int* _d,
+	global real* arr,
+	global int* weights,
+	global int* memberships,
+	global int* previous,
+	global real* distances,
+	global acc* partials,
+	global long* tallies,
+	local acc* scratch,
+	local long* tallyScratch
 ) {
-	int k = get_global_id(0);
+	int k = *_k;
 	int n = *_n;
+	int d = *_d;
 
-	double acc = 0;
-	int count = 0;
+	int lid = get_local_id(0);
+	int size = get_local_size(0);
+	int stride = get_global_size(0);
+	global acc* partial = partials + get_group_id(0) * (k * d + 1);
+	global long* tally = tallies + get_group_id(0) * (k + 1);
 
-	for (int i = 0; i < n; i++)
+	for (int c = 0; c < k; c++)
 	{
-		if (k == memberships[i])
+		// Accumulate the members of centroid `c` among the points of the work-item.
+		for (int j = 0; j < d; j++)
+			scratch[j * size + lid] = 0;
+		tallyScratch[lid] = 0;
+
+		for (int i = get_global_id(0); i < n; i += stride)
 		{
-			acc += arr[i];
-			++count;
+			int current = memberships[i];
+			int last = previous[i];
+			if (current == last || (current != c && last != c))
+				continue;
+
+			long weight = (weights != 0 ? weights[i] : 1) * (current == c ? 1 : -1);
+			for (int j = 0; j < d; j++)
+				scratch[j * size + lid] += weight * (acc)arr[j * n + i];
+			tallyScratch[lid] += weight;
 		}
+
+		reduceLocal(scratch, d, tallyScratch);
+
+		if (lid == 0)
+		{
+			for (int j = 0; j < d; j++)
+				partial[c * d + j] = scratch[j * size];
+			tally[c] = tallyScratch[0];
+		}
+
+		// Ensure the reduced values are read before scratch is reused.
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	scratch[lid] = 0;
+	tallyScratch[lid] = 0;
+	for (int i = get_global_id(0); i < n; i += stride)
+	{
+		scratch[lid] += (weights != 0 ? weights[i] : 1) * (acc)distances[i];
+		tallyScratch[lid] += (memberships[i] != previous[i]);
+	}
+
+	reduceLocal(scratch, 1, tallyScratch);
+
+	if (lid == 0)
+	{
+		partial[k * d] = scratch[0];
+		tally[k] = tallyScratch[0];
 	}
+}
+
+/**
+ * Sums value `global_id(0)` of the `_groups` consecutive partials of `_m` values each, into `reduction`.
+ */
+kernel void reducePartials(
+	global int* _m,
+	global int* _groups,
+	global acc* partials,
+	global acc* reduction
+) {
+	int r = get_global_id(0);
+	int m = *_m;
+	int groups = *_groups;
+
+	acc sum = 0;
+	for (int g = 0; g < groups; g++)
+		sum += partials[g * m + r];
+
+	reduction[r] = sum;
+}
+
+/**
+ * Sums value `global_id(0)` of the `_groups` consecutive tallies of `_m` values each, into `reduction`; as
+ * `reducePartials`, in integers.
+ */
+kernel void reduceTallies(
+	global int* _m,
+	global int* _groups,
+	global long* tallies,
+	global long* reduction
+) {
+	int r = get_global_id(0);
+	int m = *_m;
+	int groups = *_groups;
+
+	long sum = 0;
+	for (int g = 0; g < groups; g++)
+		sum += tallies[g * m + r];
 
-	centroids[k] = (count == 0) ? 0 : (acc / count);
+	reduction[r] = sum;
 }
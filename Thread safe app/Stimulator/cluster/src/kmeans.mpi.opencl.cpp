@@ -1,15 +1,27 @@
 #ifdef CLUSTER_MODE_MPI_OPENCL
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <math.h>
+#include <memory>
+#include <thread>
 #include <linux/limits.h>
 #include <unistd.h>
 #include <mpich/mpi.h>
 #include <CL/cl.hpp>
 
 #include "kmeans.h"
+#include "aggregate.h"
+#include "balance.h"
+#include "lloyd.h"
+#include "loader.h"
+#include "programcache.h"
+#include "restarts.h"
+#include "seeding.h"
 #include "util.h"
+#include "warmstart.h"
+#include "writer.h"
 
 std::ostream& log()
 {
@@ -33,16 +45,150 @@ std::string getExecutablePath()
 	return str.substr(0, str.rfind('/'));
 }
 
-KMeansResult kmeans(Args args)
+/**
+ * Device buffer kept across calls of `kmeans`, reallocated only once a call needs more than it holds.
+ */
+struct DeviceBuffer
+{
+	/**
+	 * The buffer; unallocated until first reserved.
+	 */
+	cl::Buffer buffer;
+
+	/**
+	 * Size of `buffer` in bytes.
+	 */
+	size_t size = 0;
+
+	/**
+	 * Returns the buffer, first reallocating it in `ctx` with `flags` if smaller than `size` bytes.
+	 */
+	cl::Buffer& reserve(const cl::Context& ctx, cl_mem_flags flags, size_t size)
+	{
+		if (size > this->size)
+		{
+			buffer = cl::Buffer(ctx, flags, size);
+			this->size = size;
+		}
+
+		return buffer;
+	}
+};
+
+/**
+ * OpenCL program built for values of a given precision, & its kernels.
+ */
+struct OpenCLProgram
+{
+	/**
+	 * Whether the program was built.
+	 */
+	bool isBuilt = false;
+
+	cl::Program program;
+
+	cl::Kernel computeLocalMemberships;
+	cl::Kernel accumulatePartials;
+	cl::Kernel reducePartials;
+	cl::Kernel reduceTallies;
+};
+
+/**
+ * OpenCL state created by `initialize`, such that the device is discovered & the program built once per process
+ * rather than per call of `kmeans`.
+ */
+struct OpenCLState
+{
+	cl::Device device;
+	cl::Context ctx;
+	cl::CommandQueue q;
+
+	/**
+	 * Whether the device supports double precision, in which sums are then accumulated on it whatever the precision of
+	 * the values.
+	 */
+	bool hasDoubles = false;
+
+	/**
+	 * Source of the OpenCL program, & the path it was read from.
+	 */
+	std::string source;
+	std::string sourcePath;
+
+	/**
+	 * Program built for each `Precision`; the program of the precision of `initialize`'s arguments is built by
+	 * `initialize`, & others once first needed.
+	 */
+	OpenCLProgram programs[2];
+
+	/**
+	 * Device buffers whose contents don't outlive a call, reused across calls.
+	 */
+	DeviceBuffer centroidsBuf;
+	DeviceBuffer membershipsBuf;
+	DeviceBuffer previousBuf;
+	DeviceBuffer distancesBuf;
+	DeviceBuffer partialsBuf;
+	DeviceBuffer talliesBuf;
+	DeviceBuffer reductionBuf;
+	DeviceBuffer tallyReductionBuf;
+};
+
+/**
+ * OpenCL state of this process, if initialized.
+ */
+std::unique_ptr<OpenCLState> opencl;
+
+/**
+ * Builds the program of `state` for values of `precision` (defining their type as `VALUE_TYPE`, & that of the sums
+ * accumulated as `ACC_TYPE`), unless already built. Returns 0 if built, or -8 otherwise; the root writes the build log
+ * if `isRoot`.
+ */
+int loadProgram(OpenCLState& state, Precision precision, bool isRoot)
+{
+	OpenCLProgram& program = state.programs[(int)precision];
+	if (program.isBuilt)
+		return 0;
+
+	// Build OpenCL program, or load its binary cached by a previous build.
+	std::string options = precision == Precision::Single ? "-D VALUE_TYPE=float" : "-D VALUE_TYPE=double";
+	options += state.hasDoubles ? " -D ACC_TYPE=double" : " -D ACC_TYPE=float";
+
+	cl_int err = CL_SUCCESS;
+	program.program = buildProgram(state.ctx, state.device, state.source, options, state.sourcePath, &err);
+	if (err != CL_SUCCESS)
+	{
+		if (isRoot)
+		{
+			std::cerr << ": Failed to build OpenCL program with error " << err << std::endl;
+
+			if (err == CL_BUILD_PROGRAM_FAILURE)
+			{
+				std::string buildLog;
+				program.program.getBuildInfo(state.device, CL_PROGRAM_BUILD_LOG, &buildLog);
+				std::cout << buildLog << std::endl;
+			}
+		}
+
+		return -8;
+	}
+
+	program.computeLocalMemberships = cl::Kernel(program.program, "computeLocalMemberships");
+	program.accumulatePartials = cl::Kernel(program.program, "accumulatePartials");
+	program.reducePartials = cl::Kernel(program.program, "reducePartials");
+	program.reduceTallies = cl::Kernel(program.program, "reduceTallies");
+	program.isBuilt = true;
+
+	return 0;
+}
+
+int initialize(const Args& args, bool& isRoot)
 {
 	MPI_Init(nullptr, nullptr);
 
-	// Retrieve MPI rank & size
 	int mpiRank;
-	int mpiSize;
 	MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
-	MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
-	bool isRoot = (mpiRank == 0);
+	isRoot = (mpiRank == 0);
 
 	// Create OpenCL program
 	cl_int err = CL_SUCCESS;
@@ -52,7 +198,7 @@ KMeansResult kmeans(Args args)
 	if (err == CL_DEVICE_NOT_FOUND || err == CL_PLATFORM_NOT_FOUND_KHR)
 	{
 		log() << "No OpenCPL platform " << err << std::endl;
-		return { -3, isRoot };
+		return -3;
 	}
 
 	// Select first available GPU or CPU device.
@@ -65,10 +211,12 @@ KMeansResult kmeans(Args args)
 	if (gpuDevices.size() + cpuDevices.size() == 0)
 	{
 		log() << "No OpenCL devices" << std::endl;
-		return { -4, isRoot };
+		return -4;
 	}
 
-	cl::Device device = (gpuDevices.size() > 0 ? gpuDevices : cpuDevices).front();
+	std::unique_ptr<OpenCLState> state(new OpenCLState());
+	cl::Device& device = state->device;
+	device = (gpuDevices.size() > 0 ? gpuDevices : cpuDevices).front();
 
 	// Log selected platform & device.
 	if (args.verbose)
@@ -80,261 +228,604 @@ KMeansResult kmeans(Args args)
 		log() << "Using device \"" << deviceName << "\" of OpenCL platform \"" << platformName << '"' << std::endl;
 	}
 
+	cl_device_fp_config doubleConfig = 0;
+	device.getInfo(CL_DEVICE_DOUBLE_FP_CONFIG, &doubleConfig);
+	state->hasDoubles = (doubleConfig != 0);
+
 	// Create OpenCL context.
-	cl::Context ctx(device, nullptr, nullptr, nullptr, &err);
+	state->ctx = cl::Context(device, nullptr, nullptr, nullptr, &err);
 	if (err != CL_SUCCESS)
 	{
 		log() << "Failed to create OpenCL context with error " << err << std::endl;
-		return { -5, isRoot };
+		return -5;
 	}
 
 	// Create OpenCL command queue.
-	cl::CommandQueue q(ctx, device, 0, &err);
+	state->q = cl::CommandQueue(state->ctx, device, 0, &err);
 	if (err != CL_SUCCESS)
 	{
 		log() << "Failed to create OpenCL command queue with error " << err << std::endl;
 	}
 
-	// Build OpenCL program.
-	std::string clSourcePath = getExecutablePath().append("/kmeans.mpi.opencl.cl");
+	// Read the OpenCL source, & build the program for the precision of the arguments.
+	state->sourcePath = getExecutablePath().append("/kmeans.mpi.opencl.cl");
 	std::fstream clSourceFile;
-	clSourceFile.open(clSourcePath);
+	clSourceFile.open(state->sourcePath);
 	if (!clSourceFile)
 	{
-		log() << "Failed to open the OpenCL source at " << clSourcePath << std::endl;
-		return { -8, isRoot };
+		log() << "Failed to open the OpenCL source at " << state->sourcePath << std::endl;
+		return -8;
 	}
 	std::ostringstream clSourceStream;
 	clSourceStream << clSourceFile.rdbuf();
-	std::string clSource = clSourceStream.str();
+	state->source = clSourceStream.str();
+
+	int returnCode = loadProgram(*state, args.precision, isRoot);
+	if (returnCode != 0)
+		return returnCode;
+
+	opencl = std::move(state);
+	return 0;
+}
 
-	cl::Program program(ctx, clSource, true, &err);
-	if (err != CL_SUCCESS && isRoot)
+void finalize()
+{
+	opencl.reset();
+	MPI_Finalize();
+}
+
+/**
+ * Executes `kmeans` for `args`, clustering values of type `T` (which must match `args.precision`) on the device.
+ */
+template<typename T>
+KMeansResult typedKmeans(const Args& args)
+{
+	// Retrieve MPI rank & size
+	int mpiRank;
+	int mpiSize;
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+	MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+	bool isRoot = (mpiRank == 0);
+
+	if (args.algorithm != Algorithm::Lloyd)
 	{
-		std::cerr << ": Failed to build OpenCL program with error " << err << std::endl;
+		if (isRoot)
+			std::cerr << "Only the lloyd algorithm is supported by the OpenCL build." << std::endl;
 
-		if (err == CL_BUILD_PROGRAM_FAILURE)
-		{
-			std::string buildLog;
-			program.getBuildInfo(device, CL_PROGRAM_BUILD_LOG, &buildLog);
-			std::cout << buildLog << std::endl;
-		}
+		return { -10, isRoot };
 	}
 
-	// Read values at root node
-	double* rootArr = nullptr;
-	int n;
-	if (isRoot)
-	{
-		std::vector<double> v;
-		{
-			std::ifstream f(args.inputFile);
-			if (!f.is_open())
-			{
-				return { -9, isRoot };
-			}
-			double d;
-			while (f >> d)
-				v.push_back(d);
-		}
+	// Build the program for the precision of this call, unless built by `initialize` or a previous call
+	int programCode = loadProgram(*opencl, args.precision, isRoot);
+	if (programCode != 0)
+		return { programCode, isRoot };
 
-		n = v.size();
-		rootArr = new double[n];
-		std::copy(v.begin(), v.end(), rootArr);
+	OpenCLProgram& program = opencl->programs[(int)args.precision];
 
-		std::cout << "n = " << n << std::endl;
-		std::cout << "k = " << args.k << std::endl;
+	cl::Device& device = opencl->device;
+	cl::Context& ctx = opencl->ctx;
+	cl::CommandQueue& q = opencl->q;
 
-		if (args.verbose)
-		{
-			std::cout << "arr = ";
-			printArr(n, rootArr);
-			std::cout << '\n' << std::endl;
-		}
+	if (args.stateFile != nullptr)
+	{
+		if (isRoot)
+			std::cerr << "Incremental runs are only supported by the serial & OpenMP builds." << std::endl;
+
+		return { -10, isRoot };
 	}
 
-	// Broadcast number of values
-	MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	// Restarts from the same initial centroids would only find the same clusters again.
+	int restarts = args.initialCentroidsFile != nullptr ? 1 : std::max(1, args.restarts);
+
+	// Split nodes into groups, each running its share of restarts concurrently with the others
+	MPI_Comm restartGroup;
+	MPI_Comm roots;
+	int restartGroups;
+	int restartIndex = splitRestarts(restarts, restartGroup, roots, restartGroups);
 
-	// Calculate counts & displacements
-	int maxElementsPerProcess = std::ceil((float)n / mpiSize);
-	int* counts = new int[mpiSize];
-	int* displacements = new int[mpiSize];
+	int restartRank;
+	MPI_Comm_rank(restartGroup, &restartRank);
 
-	counts = new int[mpiSize];
-	displacements = new int[mpiSize];
+	// Retrieve points from input file, partitioned across the nodes of each group
+	std::vector<double> values;
+	std::vector<int> counts;
+	std::vector<int> displacements;
+	int n;
+	int d;
+	Timings timings;
+
+	if (!loadPartition(args.inputFile, restartGroup, roots, args.verbose, values, n, d, counts, displacements, timings))
 	{
-		int r = n;
-		for (int i = 0; i < mpiSize; i++)
-		{
-			if (r > maxElementsPerProcess)
-			{
-				r -= maxElementsPerProcess;
-				counts[i] = maxElementsPerProcess;
-			}
-			else if (r < 0)
-			{
-				counts[i] = 0;
-			}
-			else
-			{
-				counts[i] = r;
-				r = 0;
-			}
-			displacements[i] = (i == 0) ? 0 : displacements[i - 1] + counts[i - 1];
-		}
+		freeRestarts(restartGroup, roots);
+		return { -9, isRoot };
 	}
 
-	// Scatter rootArr across nodes
-	double* arr = new double[counts[mpiRank]];
+	if (n == 0 || args.k <= 0 || args.k > n)
+	{
+		if (isRoot)
+			std::cerr << "K must be positive, and less than the number of values to cluster." << std::endl;
 
-	MPI_Scatterv(
-		isRoot ? rootArr : nullptr, counts, displacements, MPI_DOUBLE,
-		arr, counts[mpiRank], MPI_DOUBLE,
-		0, MPI_COMM_WORLD
-	);
+		freeRestarts(restartGroup, roots);
+		return { -4, isRoot };
+	}
 
-	// Calculate initial centroids randomly on the root
-	double* centroids = new double[args.k];
+	if (args.aggregation != Aggregation::None && d != 1)
+	{
+		if (isRoot)
+			std::cerr << "Aggregation only supports 1-dimensional values." << std::endl;
 
-	if (isRoot)
+		freeRestarts(restartGroup, roots);
+		return { -16, isRoot };
+	}
+
+	if (args.rebalance > 0 && args.aggregation != Aggregation::None)
 	{
-		for (int i = 0; i < args.k; i++)
-		{
-			while (true)
-			{
-				centroids[i] = rand() % n;
-				bool occurs = false;
+		if (isRoot)
+			std::cerr << "Rebalancing isn't supported with aggregation." << std::endl;
 
-				for (int j = 0; !occurs && j < i; j++)
-					occurs = centroids[j] == centroids[i];
+		freeRestarts(restartGroup, roots);
+		return { -18, isRoot };
+	}
 
-				if (!occurs)
-					break;
-			}
-		}
+	// Start every restart from the specified initial centroids, if any, read by the root.
+	std::vector<double> initialCentroids;
+	if (args.initialCentroidsFile != nullptr
+		&& !loadCentroidsParallel(args.initialCentroidsFile, MPI_COMM_WORLD, args.k, d, initialCentroids))
+	{
+		freeRestarts(restartGroup, roots);
+		return { -19, isRoot };
+	}
 
-		for (int i = 0; i < args.k; i++)
-			centroids[i] = rootArr[(int)centroids[i]];
+	if (isRoot)
+	{
+		std::cout << "n = " << n << std::endl;
+		std::cout << "d = " << d << std::endl;
+		std::cout << "k = " << args.k << std::endl;
+		std::cout << "restarts = " << restarts << std::endl;
 	}
 
-	MPI_Request doneRequest;
-	MPI_Irecv(nullptr, 0, MPI_INT, 0, 0xDEAD, MPI_COMM_WORLD, &doneRequest);
+	int localN = counts[restartRank];
+	Points points = { localN, d, localN, values.data() };
 
-	int* rootNewMemberships = nullptr;
-	int* rootOldMemberships = nullptr;
+	// Collapse local values into weighted values, if requested, & cluster those instead (with their weights on the
+	// device); memberships are expanded back to every local value once clustered.
+	Clock::time_point tPhase = Clock::now();
+	Aggregate aggregate;
+	Points clustered = points;
 
-	// Retrieve OpenCL kernels, create buffers & set args that are loop invariant.
+	if (args.aggregation != Aggregation::None)
+	{
+		aggregatePartition(points, args.aggregation, args.bins, restartGroup, aggregate);
+		clustered = aggregate.points();
 
-	cl::Kernel computeLocalMemberships(program, "computeLocalMemberships");
+		int aggregatedN = clustered.n;
+		MPI_Allreduce(MPI_IN_PLACE, &aggregatedN, 1, MPI_INT, MPI_SUM, restartGroup);
+		if (isRoot)
+			std::cout << "aggregated = " << aggregatedN << std::endl;
+	}
 
-	cl::Buffer kBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &args.k);
-	computeLocalMemberships.setArg(0, kBuf);
+	tPhase = timings.lap(Phase::Aggregate, tPhase);
+
+	// Convert the values to cluster to the precision of the device, copying them only if single precision, & their
+	// weights (counts of values) to integers, such that counts stay exact on the device.
+	std::vector<T> convertedValues;
+	BasicPoints<T> converted = convertPoints(clustered, convertedValues);
+	std::vector<int> convertedWeights(aggregate.weights.begin(), aggregate.weights.end());
+	tPhase = timings.lap(Phase::Load, tPhase);
+
+	T* arr = (T*)converted.values;
+	int clusteredN = clustered.n;
+
+	// Local memberships, only read from the device once a run converged, & those of the best run of the group.
+	std::vector<int> memberships(clusteredN);
+	std::vector<int> bestMemberships(clusteredN);
+
+	// Running sums & counts of the members of each centroid across the group, updated by the changes of each iteration:
+	// those of the local sums & counts, followed by the number of changed memberships & the squared distances of values
+	// to their centroids (for telemetry), laid out contiguously so that they're read from the device & combined across
+	// nodes in one go.
+	std::vector<double> totals(args.k * d + args.k);
+	double* sums = totals.data();
+	double* centroidCounts = totals.data() + args.k * d;
+
+	int reductionSize = args.k * d + args.k + 2;
+	std::vector<double> reductionValues(reductionSize);
+	double* reduction = reductionValues.data();
+	double& changed = reduction[args.k * d + args.k];
+	double& squared = reduction[args.k * d + args.k + 1];
+
+	// Centroids as transferred to the device, in its precision, & the reduction as transferred from it: the sums
+	// followed by the squared distances, accumulated in double precision wherever the device supports it (& read into
+	// `singleSums` first otherwise), & the counts followed by the number of changes, as integers.
+	std::vector<T> deviceCentroids(args.k * d);
+	int sumsSize = args.k * d + 1;
+	int talliesSize = args.k + 1;
+	size_t accSize = opencl->hasDoubles ? sizeof(cl_double) : sizeof(cl_float);
+	std::vector<double> deviceSums(sumsSize);
+	std::vector<cl_float> singleSums(opencl->hasDoubles ? 0 : sumsSize);
+	std::vector<cl_long> deviceTallies(talliesSize);
+
+	// Size the workgroups accumulating partials, such that each work-item's scratch (d sums & a count) fits in local
+	// memory & the workgroup size is a power of two (for the tree reduction). Only as many workgroups as keep each
+	// compute unit busy are used, to keep the partials reduced afterwards few.
+	cl::Kernel& computeLocalMemberships = program.computeLocalMemberships;
+	cl::Kernel& accumulatePartials = program.accumulatePartials;
+	cl::Kernel& reducePartials = program.reducePartials;
+	cl::Kernel& reduceTallies = program.reduceTallies;
+
+	size_t maxGroupSize = 1;
+	accumulatePartials.getWorkGroupInfo(device, CL_KERNEL_WORK_GROUP_SIZE, &maxGroupSize);
+	cl_ulong localMemSize = 0;
+	device.getInfo(CL_DEVICE_LOCAL_MEM_SIZE, &localMemSize);
+	cl_uint computeUnits = 1;
+	device.getInfo(CL_DEVICE_MAX_COMPUTE_UNITS, &computeUnits);
+
+	maxGroupSize = std::min(maxGroupSize, (size_t)(localMemSize / (accSize * d + sizeof(cl_long))));
+	int groupSize = 1;
+	while (groupSize * 2 <= (int)maxGroupSize)
+		groupSize *= 2;
+
+	// Create device buffers of the sizes of this call, reuse the others across calls (where large enough), and set args
+	// that are loop invariant.
+	int k = args.k;
+	cl::Buffer kBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &k);
+	cl::Buffer dBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &d);
+	cl::Buffer sumsSizeBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &sumsSize);
+	cl::Buffer talliesSizeBuf(
+		ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &talliesSize
+	);
+	cl::Buffer& centroidsBuf = opencl->centroidsBuf.reserve(
+		ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY, sizeof(T) * args.k * d
+	);
+	cl::Buffer& reductionBuf = opencl->reductionBuf.reserve(
+		ctx, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, accSize * sumsSize
+	);
+	cl::Buffer& tallyReductionBuf = opencl->tallyReductionBuf.reserve(
+		ctx, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, sizeof(cl_long) * talliesSize
+	);
 
-	cl::Buffer arrBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(double) * counts[mpiRank], arr);
-	computeLocalMemberships.setArg(1, arrBuf);
+	computeLocalMemberships.setArg(0, kBuf);
+	computeLocalMemberships.setArg(2, dBuf);
+	computeLocalMemberships.setArg(4, centroidsBuf);
+
+	accumulatePartials.setArg(0, kBuf);
+	accumulatePartials.setArg(2, dBuf);
+	accumulatePartials.setArg(10, cl::Local(accSize * groupSize * d));
+	accumulatePartials.setArg(11, cl::Local(sizeof(cl_long) * groupSize));
+
+	reducePartials.setArg(0, sumsSizeBuf);
+	reducePartials.setArg(3, reductionBuf);
+
+	reduceTallies.setArg(0, talliesSizeBuf);
+	reduceTallies.setArg(3, tallyReductionBuf);
+
+	// Create (or reserve) device buffers sized by the local values & set their args; bound again whenever the values are
+	// repartitioned across nodes.
+	int groups;
+	cl::Buffer nBuf;
+	cl::Buffer groupsBuf;
+	cl::Buffer arrBuf;
+	cl::Buffer weightsBuf;
+	cl::Buffer& membershipsBuf = opencl->membershipsBuf.buffer;
+	cl::Buffer& previousBuf = opencl->previousBuf.buffer;
+	cl::Buffer& distancesBuf = opencl->distancesBuf.buffer;
+	cl::Buffer& partialsBuf = opencl->partialsBuf.buffer;
+	cl::Buffer& talliesBuf = opencl->talliesBuf.buffer;
+
+	auto bindValues = [&]()
+	{
+		groups = std::max(1, std::min((int)computeUnits * 4, (clusteredN + groupSize - 1) / groupSize));
 
-	cl::Kernel recomputeCentroids(program, "recomputeCentroids");
+		nBuf = cl::Buffer(
+			ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &clusteredN
+		);
+		groupsBuf = cl::Buffer(
+			ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &groups
+		);
+		arrBuf = cl::Buffer(
+			ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(T) * clusteredN * d, arr
+		);
+		if (args.aggregation != Aggregation::None)
+		{
+			weightsBuf = cl::Buffer(
+				ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int) * clusteredN,
+				convertedWeights.data()
+			);
+		}
+		opencl->membershipsBuf.reserve(ctx, CL_MEM_READ_WRITE, sizeof(int) * clusteredN);
+		opencl->previousBuf.reserve(ctx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(int) * clusteredN);
+		opencl->distancesBuf.reserve(ctx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(T) * clusteredN);
+		opencl->partialsBuf.reserve(ctx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, accSize * groups * sumsSize);
+		opencl->talliesBuf.reserve(
+			ctx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(cl_long) * groups * talliesSize
+		);
 
-	cl::Buffer nBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int), &n);
-	recomputeCentroids.setArg(0, nBuf);
+		computeLocalMemberships.setArg(1, nBuf);
+		computeLocalMemberships.setArg(3, arrBuf);
+		computeLocalMemberships.setArg(5, membershipsBuf);
+		computeLocalMemberships.setArg(6, previousBuf);
+		computeLocalMemberships.setArg(7, distancesBuf);
+
+		accumulatePartials.setArg(1, nBuf);
+		accumulatePartials.setArg(3, arrBuf);
+		accumulatePartials.setArg(4, weightsBuf);
+		accumulatePartials.setArg(5, membershipsBuf);
+		accumulatePartials.setArg(6, previousBuf);
+		accumulatePartials.setArg(7, distancesBuf);
+		accumulatePartials.setArg(8, partialsBuf);
+		accumulatePartials.setArg(9, talliesBuf);
+
+		reducePartials.setArg(1, groupsBuf);
+		reducePartials.setArg(2, partialsBuf);
+
+		reduceTallies.setArg(1, groupsBuf);
+		reduceTallies.setArg(2, talliesBuf);
+	};
+
+	bindValues();
+
+	// Seed restarts from the root, such that each runs from different initial centroids.
+	unsigned long seed = rand();
+	MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+
+	KMeansRun best;
+	std::vector<double> centroidValues(args.k * d);
+	double* centroids = centroidValues.data();
+
+	// Statistics of each iteration are recorded by every node, & gathered on the root once every group is done; with
+	// the bytes each node communicated since its previous iteration, i.e. seeding, the reduction & rebalancing.
+	Telemetry telemetry;
+	bool recording = (args.telemetryOutputFile != nullptr);
+	std::vector<double> previous;
+	Traffic traffic;
+	Traffic recorded;
+
+	if (recording)
+	{
+		telemetry.residual = aggregate.residual;
+		MPI_Allreduce(MPI_IN_PLACE, &telemetry.residual, 1, MPI_DOUBLE, MPI_SUM, restartGroup);
+	}
 
-	cl::Buffer rootArrBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(double) * n, rootArr);
-	recomputeCentroids.setArg(1, rootArrBuf);
+	tPhase = Clock::now();
 
-	do
+	for (int r = restartIndex; r < restarts; r += restartGroups)
 	{
-		// Broadcast centroids
-		MPI_Request centroidsBcastRequest;
-		MPI_Ibcast(centroids, args.k, MPI_DOUBLE, 0, MPI_COMM_WORLD, &centroidsBcastRequest);
+		// Calculate initial centroids with k-means|| across the nodes of the group, unless specified, & reset
+		// memberships on the device
+		if (!initialCentroids.empty())
+			std::copy(initialCentroids.begin(), initialCentroids.end(), centroids);
+		else
+			kmeansParallel(converted, args.k, centroids, restartGroup, seed + r, &traffic);
+
+		std::fill(memberships.begin(), memberships.end(), -1);
+		q.enqueueWriteBuffer(membershipsBuf, CL_NON_BLOCKING, 0, sizeof(int) * clusteredN, memberships.data());
+		std::fill(totals.begin(), totals.end(), 0.0);
+		tPhase = timings.lap(Phase::Seed, tPhase);
+
+		int iterations = 0;
+		double shift;
+		double maxShift;
+
+		do
+		{
+			++iterations;
+			Clock::time_point tIteration = tPhase;
+
+			// Compute local memberships
+			if (recording)
+				previous.assign(centroids, centroids + args.k * d);
+
+			std::copy(centroids, centroids + args.k * d, deviceCentroids.begin());
+			q.enqueueWriteBuffer(centroidsBuf, CL_NON_BLOCKING, 0, sizeof(T) * args.k * d, deviceCentroids.data());
+			q.enqueueNDRangeKernel(computeLocalMemberships, cl::NDRange(0), cl::NDRange(clusteredN));
+
+			// Compute the changes of local sums & counts (from the values whose membership changed only), & the number
+			// of changes, reduced per workgroup & then across workgroups on the device
+			q.enqueueNDRangeKernel(
+				accumulatePartials, cl::NDRange(0), cl::NDRange(groups * groupSize), cl::NDRange(groupSize)
+			);
+			q.enqueueNDRangeKernel(reducePartials, cl::NDRange(0), cl::NDRange(sumsSize));
+			q.enqueueNDRangeKernel(reduceTallies, cl::NDRange(0), cl::NDRange(talliesSize));
+			q.enqueueReadBuffer(
+				tallyReductionBuf, CL_NON_BLOCKING, 0, sizeof(cl_long) * talliesSize, deviceTallies.data()
+			);
+			if (opencl->hasDoubles)
+				q.enqueueReadBuffer(reductionBuf, CL_BLOCKING, 0, sizeof(cl_double) * sumsSize, deviceSums.data());
+			else
+			{
+				q.enqueueReadBuffer(reductionBuf, CL_BLOCKING, 0, sizeof(cl_float) * sumsSize, singleSums.data());
+				std::copy(singleSums.begin(), singleSums.end(), deviceSums.begin());
+			}
 
-		// Await completion of either doneRequest or centroidBcastRequest
-		MPI_Request requests[] = { doneRequest, centroidsBcastRequest };
-		int requestCompletedIdx = -1;
-		MPI_Waitany(2, requests, &requestCompletedIdx, MPI_STATUS_IGNORE);
+			std::copy(deviceSums.begin(), deviceSums.end() - 1, reduction);
+			std::copy(deviceTallies.begin(), deviceTallies.end() - 1, reduction + args.k * d);
+			changed = deviceTallies[args.k];
+			squared = deviceSums[args.k * d];
 
-		if (requestCompletedIdx == 0)
-			break;
+			// Every so often, reduce the local sums & counts accumulated afresh (from memberships read from the
+			// device) instead of their changes, replacing the running ones (which drift by the rounding of every
+			// change).
+			bool isReaccumulating = (iterations % REACCUMULATE_INTERVAL == 0);
+			if (isReaccumulating)
+			{
+				q.enqueueReadBuffer(membershipsBuf, CL_BLOCKING, 0, sizeof(int) * clusteredN, memberships.data());
+				accumulateMembers(converted, args.k, memberships.data(), reduction, reduction + args.k * d);
+			}
 
-		// Compute local memberships
-		cl::Buffer centroidsBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(double) * args.k, centroids);
-		computeLocalMemberships.setArg(2, centroidsBuf);
+			tPhase = timings.lap(Phase::Assign, tPhase);
 
-		cl::Buffer membershipsBuf(ctx, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, sizeof(int) * counts[mpiRank]);
-		computeLocalMemberships.setArg(3, membershipsBuf);
+			// Combine changes across nodes into the running sums & counts, and recompute centroids on each node
+			MPI_Allreduce(MPI_IN_PLACE, reduction, reductionSize, MPI_DOUBLE, MPI_SUM, restartGroup);
+			traffic.allreduce(restartGroup, sizeof(double) * reductionSize);
+			for (int i = 0; i < args.k * d + args.k; i++)
+				totals[i] = isReaccumulating ? reduction[i] : totals[i] + reduction[i];
 
-		int* memberships = new int[counts[mpiRank]];
-		q.enqueueNDRangeKernel(computeLocalMemberships, cl::NDRange(0), cl::NDRange(counts[mpiRank]));
-		q.enqueueReadBuffer(membershipsBuf, CL_BLOCKING, 0, sizeof(int) * counts[mpiRank], memberships);
-		cl::finish();
+			shift = updateCentroids(args.k, d, sums, centroidCounts, centroids, &maxShift);
 
-		// Gather memberships on root
-		bool rootPopulateOld = false;
-		if (isRoot)
-		{
-			if (rootOldMemberships == nullptr)
+			// Output iteration data
+			if (isRoot && args.verbose && restarts == 1)
 			{
-				rootOldMemberships = new int[n];
-				rootPopulateOld = true;
+				std::cout << "centroids = ";
+				printArr(args.k * d, centroids);
+				std::cout << "\nchanged = " << changed << "\nshift = " << shift << '\n' << std::endl;
 			}
-			else if (rootNewMemberships == nullptr)
+
+			tPhase = timings.lap(Phase::Reduce, tPhase);
+			long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tPhase - tIteration).count();
+
+			// Once the first iterations of the group's first run are timed, repartition values in proportion to the
+			// throughput of each node (e.g. across devices of unequal speed); memberships are read from the device &
+			// move along with their values, which are then bound to the device again.
+			bool isRebalancing = (args.rebalance > 0 && r == restartIndex && iterations == args.rebalance);
+			std::vector<double> weights;
+
+			if (isRebalancing)
 			{
-				rootNewMemberships = new int[n];
+				std::vector<int> fromCounts = counts;
+				std::vector<int> fromDisplacements = displacements;
+
+				if (balancePartition(timings[Phase::Assign], restartGroup, counts, displacements, weights, &traffic))
+				{
+					q.enqueueReadBuffer(membershipsBuf, CL_BLOCKING, 0, sizeof(int) * clusteredN, memberships.data());
+
+					redistribute(
+						values, d, fromCounts, fromDisplacements, counts, displacements, restartGroup, &traffic
+					);
+					redistribute(
+						memberships, 1, fromCounts, fromDisplacements, counts, displacements, restartGroup, &traffic
+					);
+
+					localN = counts[restartRank];
+					points = { localN, d, localN, values.data() };
+					clustered = points;
+					converted = convertPoints(clustered, convertedValues);
+					arr = (T*)converted.values;
+					clusteredN = clustered.n;
+					bestMemberships.resize(clusteredN);
+
+					bindValues();
+					q.enqueueWriteBuffer(membershipsBuf, CL_BLOCKING, 0, sizeof(int) * clusteredN, memberships.data());
+				}
+
+				if (isRoot)
+				{
+					std::cout << "weights = ";
+					printArr(weights.size(), weights.data());
+					std::cout << std::endl;
+				}
+
+				tPhase = timings.lap(Phase::Scatter, tPhase);
 			}
-			else
+
+			if (recording)
 			{
-				for (int i = 0;  i < n; i++)
-					rootOldMemberships[i] = rootNewMemberships[i];
+				double inertia = telemetry.inertia(args.k, d, previous.data(), sums, centroidCounts, squared);
+				long sent = traffic.sent - recorded.sent;
+				long received = traffic.received - recorded.received;
+				telemetry.record({ mpiRank, r, iterations, inertia, changed, maxShift, ns, sent, received });
+				recorded = traffic;
+
+				if (isRebalancing && restartRank == 0)
+					telemetry.recordPartition(r, iterations, weights, counts);
 			}
 		}
+		while (!hasConverged(iterations, changed, shift, args.tolerance, args.maxIterations));
 
-		MPI_Gatherv(
-			memberships, counts[mpiRank], MPI_INT,
-			isRoot ? (rootPopulateOld ? rootOldMemberships : rootNewMemberships) : nullptr, counts, displacements, MPI_INT,
-			0, MPI_COMM_WORLD
-		);
+		q.enqueueReadBuffer(membershipsBuf, CL_BLOCKING, 0, sizeof(int) * clusteredN, memberships.data());
+		tPhase = timings.lap(Phase::Gather, tPhase);
 
-		delete[] memberships;
+		// The final centroids are the means of their members as accumulated afresh, independent of the changes
+		accumulateMembers(converted, args.k, memberships.data(), sums, centroidCounts);
+		MPI_Allreduce(MPI_IN_PLACE, totals.data(), args.k * d + args.k, MPI_DOUBLE, MPI_SUM, restartGroup);
+		updateCentroids(args.k, d, sums, centroidCounts, centroids);
 
-		// Recompute centroids
-		if (isRoot)
+		// Keep the run if it's the best of the group so far
+		double inertia = computeInertia(converted, centroids, memberships.data()) + aggregate.residual;
+		MPI_Allreduce(MPI_IN_PLACE, &inertia, 1, MPI_DOUBLE, MPI_SUM, restartGroup);
+
+		if (inertia < best.inertia)
 		{
-			cl::Buffer rootCentroidsBuf(ctx, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, sizeof(double) * args.k, centroids);
-			recomputeCentroids.setArg(2, rootCentroidsBuf);
+			best.inertia = inertia;
+			best.iterations = iterations;
+			best.centroids.assign(centroids, centroids + args.k * d);
+			std::swap(memberships, bestMemberships);
+		}
 
-			cl::Buffer rootMembershipsBuf(ctx, CL_MEM_READ_ONLY | CL_MEM_HOST_READ_ONLY | CL_MEM_USE_HOST_PTR, sizeof(int) * n, rootPopulateOld ? rootOldMemberships : rootNewMemberships);
-			recomputeCentroids.setArg(3, rootMembershipsBuf);
+		tPhase = timings.lap(Phase::Reduce, tPhase);
+	}
 
-			q.enqueueNDRangeKernel(recomputeCentroids, cl::NDRange(0), cl::NDRange(args.k));
-			q.enqueueReadBuffer(rootCentroidsBuf, CL_BLOCKING, 0, args.k, centroids);
-			cl::finish();
+	// Find the group that found the best run, whose nodes write its memberships, & select its centroids on the root
+	struct { double inertia; int index; } bestGroup = { best.inertia, restartIndex };
+	MPI_Allreduce(MPI_IN_PLACE, &bestGroup, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
 
-			// Output iteration data
-			if (args.verbose)
-			{
-				std::cout << "centroids = ";
-				printArr(args.k, centroids);
-				std::cout << std::endl;
+	if (roots != MPI_COMM_NULL)
+		selectBestRun(best, 0, args.k * d, roots);
 
-				std::cout << "memberships = ";
-				printArr(n, rootPopulateOld ? rootOldMemberships : rootNewMemberships);
+	if (recording)
+		gatherTelemetry(telemetry, MPI_COMM_WORLD);
 
-				std::cout << '\n' << std::endl;
-			}
-		}
+	tPhase = timings.lap(Phase::Gather, tPhase);
+
+	// Expand memberships of the best run's weighted values back to every local value, where they're scored or written
+	bool isBest = (restartIndex == bestGroup.index);
+	if (isBest && args.aggregation != Aggregation::None && (args.quality || args.membershipOutputFile != nullptr))
+	{
+		memberships.resize(localN);
+		aggregate.expand(points, bestMemberships.data(), memberships.data());
+		std::swap(memberships, bestMemberships);
+		tPhase = timings.lap(Phase::Aggregate, tPhase);
 	}
-	while (!isRoot || rootOldMemberships == nullptr || rootNewMemberships == nullptr || !arraysEqual(n, rootOldMemberships, rootNewMemberships));
 
-	// Terminate involved processes
-	if (isRoot)
+	// Score the clusters of the best run across every node, of which only those of its group hold values
+	QualityScores scores;
+	if (args.quality)
 	{
-		for (int i = 1; i < mpiSize; i++)
-			MPI_Send(nullptr, 0, MPI_INT, i, 0xDEAD, MPI_COMM_WORLD);
+		Points scored = isBest ? points : Points{ 0, d, 0, nullptr };
+		int threads = std::max(1u, std::thread::hardware_concurrency());
+		scores = scoreClustersParallel(
+			scored, args.k, best.centroids.data(), bestMemberships.data(), threads, MPI_COMM_WORLD
+		);
+		tPhase = timings.lap(Phase::Score, tPhase);
 	}
 
-	// Finalize & return
-	MPI_Finalize();
-	return { 0, isRoot, n, rootNewMemberships, centroids };
+	// Write memberships of the best run directly from the nodes of its group, rather than gathering them on the root
+	if (args.membershipOutputFile != nullptr)
+	{
+		int written = 1;
+		if (isBest)
+		{
+			written = writeMembershipsParallel(
+				args.membershipOutputFile, restartGroup, localN, bestMemberships.data(), args.outputFormat
+			);
+		}
+
+		MPI_Allreduce(MPI_IN_PLACE, &written, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+		if (!written)
+		{
+			freeRestarts(restartGroup, roots);
+			return { -6, isRoot };
+		}
+
+		if (isRoot)
+			std::cout << "Wrote memberships to " << args.membershipOutputFile << std::endl;
+
+		timings.lap(Phase::Write, tPhase);
+	}
+
+	freeRestarts(restartGroup, roots);
+
+	if (isRoot)
+		std::cout << "iterations = " << best.iterations << std::endl;
+
+	// Report the time of the slowest node in each phase
+	MPI_Reduce(isRoot ? MPI_IN_PLACE : timings.ns, timings.ns, PHASE_COUNT, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	return { 0, isRoot, n, d, {}, std::move(best.centroids), timings, best.inertia, telemetry, {}, scores };
+}
+
+KMeansResult kmeans(Args args)
+{
+	return args.precision == Precision::Single ? typedKmeans<float>(args) : typedKmeans<double>(args);
 }
 
 #endif
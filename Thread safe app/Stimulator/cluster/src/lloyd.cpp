@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "lloyd.h"
+
+/**
+ * Number of points processed per block by `assignAndAccumulate`.
+ */
+const int BLOCK_SIZE = 256;
+
+template<typename T>
+int assignAndAccumulate(
+	const BasicPoints<T>& points,
+	int k, const double* centroids,
+	int* memberships,
+	double* sums, double* counts, double* squares
+)
+{
+	int d = points.d;
+	bool accumulating = (sums != nullptr && counts != nullptr);
+	int changed = 0;
+
+	T diffs[BLOCK_SIZE];
+	T minDiffs[BLOCK_SIZE];
+	int minIdxs[BLOCK_SIZE];
+
+	for (int start = 0; start < points.n; start += BLOCK_SIZE)
+	{
+		int size = std::min(BLOCK_SIZE, points.n - start);
+
+		// Compute the closest centroid of each point in the block, one centroid at a time.
+		for (int i = 0; i < size; i++)
+		{
+			minDiffs[i] = std::numeric_limits<T>::infinity();
+			minIdxs[i] = 0;
+		}
+
+		for (int c = 0; c < k; c++)
+		{
+			const double* centroid = centroids + c * d;
+
+			for (int i = 0; i < size; i++)
+				diffs[i] = 0;
+
+			for (int j = 0; j < d; j++)
+			{
+				const T* block = points.dim(j) + start;
+				T coordinate = (T)centroid[j];
+
+				for (int i = 0; i < size; i++)
+				{
+					T diff = block[i] - coordinate;
+					diffs[i] += diff * diff;
+				}
+			}
+
+			for (int i = 0; i < size; i++)
+			{
+				bool closer = diffs[i] < minDiffs[i];
+				minDiffs[i] = closer ? diffs[i] : minDiffs[i];
+				minIdxs[i] = closer ? c : minIdxs[i];
+			}
+		}
+
+		if (squares != nullptr)
+		{
+			double squared = 0;
+			for (int i = 0; i < size; i++)
+				squared += points.weight(start + i) * minDiffs[i];
+
+			*squares += squared;
+		}
+
+		// Store memberships, & move the points of the block whose membership changed from the sum & count of their
+		// previous centroid (if any) to those of their new one.
+		for (int i = 0; i < size; i++)
+		{
+			int previous = memberships[start + i];
+			int current = minIdxs[i];
+			if (previous == current)
+				continue;
+
+			++changed;
+			memberships[start + i] = current;
+
+			if (!accumulating)
+				continue;
+
+			double weight = points.weight(start + i);
+			if (previous >= 0)
+			{
+				counts[previous] -= weight;
+				for (int j = 0; j < d; j++)
+					sums[previous * d + j] -= weight * points.dim(j)[start + i];
+			}
+
+			counts[current] += weight;
+			for (int j = 0; j < d; j++)
+				sums[current * d + j] += weight * points.dim(j)[start + i];
+		}
+	}
+
+	return changed;
+}
+
+template<typename T>
+double computeInertia(const BasicPoints<T>& points, const double* centroids, const int* memberships)
+{
+	int d = points.d;
+	double inertia = 0;
+
+	for (int j = 0; j < d; j++)
+	{
+		const T* dim = points.dim(j);
+		for (int i = 0; i < points.n; i++)
+		{
+			double diff = dim[i] - centroids[memberships[i] * d + j];
+			inertia += points.weight(i) * diff * diff;
+		}
+	}
+
+	return inertia;
+}
+
+template<typename T>
+void accumulateMembers(const BasicPoints<T>& points, int k, const int* memberships, double* sums, double* counts)
+{
+	int d = points.d;
+	std::fill(sums, sums + k * d, 0.0);
+	std::fill(counts, counts + k, 0.0);
+
+	for (int i = 0; i < points.n; i++)
+	{
+		if (memberships[i] >= 0)
+			counts[memberships[i]] += points.weight(i);
+	}
+
+	for (int j = 0; j < d; j++)
+	{
+		const T* dim = points.dim(j);
+		for (int i = 0; i < points.n; i++)
+		{
+			if (memberships[i] >= 0)
+				sums[memberships[i] * d + j] += points.weight(i) * dim[i];
+		}
+	}
+}
+
+template int assignAndAccumulate(const BasicPoints<float>&, int, const double*, int*, double*, double*, double*);
+template int assignAndAccumulate(const BasicPoints<double>&, int, const double*, int*, double*, double*, double*);
+template double computeInertia(const BasicPoints<float>&, const double*, const int*);
+template double computeInertia(const BasicPoints<double>&, const double*, const int*);
+template void accumulateMembers(const BasicPoints<float>&, int, const int*, double*, double*);
+template void accumulateMembers(const BasicPoints<double>&, int, const int*, double*, double*);
+
+double updateCentroids(int k, int d, const double* sums, const double* counts, double* centroids, double* maxShift)
+{
+	double shift = 0;
+	double magnitude = 0;
+	double maxCentroidShift = 0;
+
+	for (int i = 0; i < k; i++)
+	{
+		double centroidShift = 0;
+
+		for (int j = 0; j < d; j++)
+		{
+			double& centroid = centroids[i * d + j];
+			magnitude += centroid * centroid;
+
+			if (counts[i] > 0)
+			{
+				double mean = sums[i * d + j] / counts[i];
+				centroidShift += (mean - centroid) * (mean - centroid);
+				centroid = mean;
+			}
+		}
+
+		shift += centroidShift;
+		maxCentroidShift = std::max(maxCentroidShift, centroidShift);
+	}
+
+	if (maxShift != nullptr)
+		*maxShift = std::sqrt(maxCentroidShift);
+
+	return magnitude > 0 ? std::sqrt(shift / magnitude) : std::sqrt(shift);
+}
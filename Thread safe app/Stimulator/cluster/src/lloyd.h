@@ -0,0 +1,105 @@
+#ifndef LLOYD_H
+#define LLOYD_H
+
+#include <vector>
+
+#include "points.h"
+
+struct HamerlyState;
+
+/**
+ * Number of iterations after which the running sums & counts of `assignAndAccumulate` are computed afresh with
+ * `accumulateMembers`, discarding the rounding errors accumulated by adding & subtracting the points that changed.
+ */
+const int REACCUMULATE_INTERVAL = 16;
+
+/**
+ * Assigns each of the `points` to the closest (by squared Euclidean distance) of the `k` `centroids` into
+ * `memberships`, returning the number of memberships that changed from their previous value. If `sums` and `counts`
+ * are specified, they're kept as the running sums & counts of the members of each centroid, in the same pass: each
+ * point whose membership changed is subtracted from those of its previous centroid (unless its membership was -1) and
+ * added to those of its new one; weighted by the weight of the point, if `points` are weighted. Once memberships
+ * settle, accumulating costs O(changed) rather than O(n); memberships must be reset to -1 whenever `sums` and `counts`
+ * are zeroed. If `squares` is specified, the squared distance between each point and the centroid it's assigned to
+ * (times its weight) is added to it.
+ *
+ * `centroids` and `sums` hold `k` points of `points.d` dimensions each, stored consecutively; `counts` holds `k`
+ * values.
+ *
+ * Points are processed in blocks small enough to stay in cache: distances to each centroid are computed across a whole
+ * block (which the compiler vectorizes) before the block's changes are accumulated. Distances are computed in the
+ * precision of the points (such that single precision doubles the width of vectors), while sums are accumulated in
+ * double precision. No memory is allocated.
+ */
+template<typename T>
+int assignAndAccumulate(
+	const BasicPoints<T>& points,
+	int k, const double* centroids,
+	int* memberships,
+	double* sums = nullptr, double* counts = nullptr, double* squares = nullptr
+);
+
+/**
+ * Sets each of the `k` `centroids` (of `d` dimensions each) to the mean of its members, given their `sums` and
+ * `counts`. Centroids without members are left as they are.
+ *
+ * Returns how far centroids shifted relative to their magnitude, i.e. the norm of the movement of all centroids over
+ * the norm of all centroids before moving (or the norm of the movement itself, if the latter is 0). If `maxShift` is
+ * specified, it's set to the largest distance by which a single centroid moved.
+ */
+double updateCentroids(
+	int k, int d, const double* sums, const double* counts, double* centroids, double* maxShift = nullptr
+);
+
+/**
+ * Returns the inertia of `points` given their `memberships` among `centroids`, i.e. the sum of the squared
+ * (Euclidean) distances between each point and the centroid it's a member of (times its weight, if `points` are
+ * weighted).
+ */
+template<typename T>
+double computeInertia(const BasicPoints<T>& points, const double* centroids, const int* memberships);
+
+/**
+ * Sets the `sums` & `counts` of the members of each of the `k` centroids (laid out as by `assignAndAccumulate`) to
+ * those of `points` given their `memberships`, accumulated from scratch in a single pass rather than by changes.
+ * Points whose membership is -1 are skipped.
+ */
+template<typename T>
+void accumulateMembers(const BasicPoints<T>& points, int k, const int* memberships, double* sums, double* counts);
+
+#ifdef CLUSTER_OPENMP
+
+/**
+ * Performs `assignAndAccumulate` across OpenMP threads, each over a contiguous slice of `points` & into its own partial
+ * changes of `sums`, `counts` and `squares` (if specified), which are added to them once every thread is done. Returns
+ * the number of memberships that changed.
+ *
+ * If `hamerly` is specified, each thread prunes its slice with `hamerlyAssignAndAccumulate` instead, keeping its state
+ * in the element of `hamerly` at its thread number; it must hold `omp_get_max_threads()` states, and the number of
+ * threads must be the same across calls.
+ */
+template<typename T>
+int parallelAssignAndAccumulate(
+	const BasicPoints<T>& points,
+	int k, const double* centroids,
+	int* memberships,
+	double* sums, double* counts, double* squares = nullptr,
+	std::vector<HamerlyState>* hamerly = nullptr
+);
+
+/**
+ * Concatenates the per-thread Hamerly `states` of `parallelAssignAndAccumulate` into `state`, i.e. the state of every
+ * point in order, such that it can be moved along with its points (see `splitHamerlyState`).
+ */
+void joinHamerlyStates(const std::vector<HamerlyState>& states, HamerlyState& state);
+
+/**
+ * Splits the Hamerly `state` of every point into the per-thread `states` of `parallelAssignAndAccumulate` (as many as
+ * `states` holds), such that each thread's state covers the slice of points it's assigned; the reverse of
+ * `joinHamerlyStates`.
+ */
+void splitHamerlyState(const HamerlyState& state, std::vector<HamerlyState>& states);
+
+#endif
+
+#endif
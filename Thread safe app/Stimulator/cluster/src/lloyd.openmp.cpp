@@ -0,0 +1,99 @@
+#ifdef CLUSTER_OPENMP
+
+#include <algorithm>
+#include <omp.h>
+
+#include "lloyd.h"
+#include "hamerly.h"
+
+/**
+ * Returns the index of the first of the `n` points in the slice of `thread` of `threads`.
+ */
+int sliceStart(int n, int thread, int threads)
+{
+	return (int)((long)n * thread / threads);
+}
+
+template<typename T>
+int parallelAssignAndAccumulate(
+	const BasicPoints<T>& points,
+	int k, const double* centroids,
+	int* memberships,
+	double* sums, double* counts, double* squares,
+	std::vector<HamerlyState>* hamerly
+)
+{
+	int d = points.d;
+	int changed = 0;
+	double squared = 0;
+
+	// Each thread accumulates the changes of its slice into private copies of sums, counts & squares (zeroed by
+	// OpenMP), added to the shared ones once the threads join.
+	#pragma omp parallel reduction(+: changed, squared, sums[:k * d], counts[:k])
+	{
+		int thread = omp_get_thread_num();
+		int threads = omp_get_num_threads();
+
+		int start = sliceStart(points.n, thread, threads);
+		int end = sliceStart(points.n, thread + 1, threads);
+		BasicPoints<T> slice = points.slice(start, end - start);
+
+		double* localSquares = squares != nullptr ? &squared : nullptr;
+
+		if (hamerly != nullptr)
+		{
+			changed += hamerlyAssignAndAccumulate(
+				slice, k, centroids, memberships + start, sums, counts, localSquares, (*hamerly)[thread]
+			);
+		}
+		else
+		{
+			changed += assignAndAccumulate(slice, k, centroids, memberships + start, sums, counts, localSquares);
+		}
+	}
+
+	if (squares != nullptr)
+		*squares += squared;
+
+	return changed;
+}
+
+template int parallelAssignAndAccumulate(
+	const BasicPoints<float>&, int, const double*, int*, double*, double*, double*, std::vector<HamerlyState>*
+);
+template int parallelAssignAndAccumulate(
+	const BasicPoints<double>&, int, const double*, int*, double*, double*, double*, std::vector<HamerlyState>*
+);
+
+void joinHamerlyStates(const std::vector<HamerlyState>& states, HamerlyState& state)
+{
+	state = HamerlyState();
+	state.centroids = states.front().centroids;
+
+	for (const HamerlyState& slice : states)
+	{
+		state.assignments.insert(state.assignments.end(), slice.assignments.begin(), slice.assignments.end());
+		state.upper.insert(state.upper.end(), slice.upper.begin(), slice.upper.end());
+		state.lower.insert(state.lower.end(), slice.lower.begin(), slice.lower.end());
+	}
+}
+
+void splitHamerlyState(const HamerlyState& state, std::vector<HamerlyState>& states)
+{
+	int n = state.assignments.size();
+	int threads = states.size();
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		int start = sliceStart(n, thread, threads);
+		int end = sliceStart(n, thread + 1, threads);
+		HamerlyState& slice = states[thread];
+
+		slice.assignments.assign(state.assignments.begin() + start, state.assignments.begin() + end);
+		slice.upper.assign(state.upper.begin() + start, state.upper.begin() + end);
+		slice.lower.assign(state.lower.begin() + start, state.lower.begin() + end);
+		slice.centroids = state.centroids;
+	}
+}
+
+#endif
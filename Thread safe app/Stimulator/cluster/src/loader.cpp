@@ -0,0 +1,523 @@
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <limits.h>
+#include <string.h>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "loader.h"
+
+const char BINARY_MAGIC[8] = { 'C', 'L', 'U', 'S', 'T', 'B', 'I', 'N' };
+
+/**
+ * Minimum number of bytes of a text input file parsed by each thread.
+ */
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+bool isValidHeader(const BinaryHeader& header, uint64_t size)
+{
+	if (header.valueSize != sizeof(double) || header.d == 0 || header.d > INT_MAX || size < sizeof(BinaryHeader))
+		return false;
+
+	// Divide rather than multiply, such that no product of the header's fields can overflow.
+	uint64_t valuesSize = size - sizeof(BinaryHeader);
+	uint64_t pointSize = (uint64_t)header.d * sizeof(double);
+	return valuesSize % pointSize == 0 && valuesSize / pointSize == header.n;
+}
+
+Dataset::~Dataset()
+{
+	clear();
+}
+
+Points Dataset::points() const
+{
+	return { n, d, n, values };
+}
+
+void Dataset::clear()
+{
+	if (mapping != nullptr)
+		munmap(mapping, mappingSize);
+
+	std::vector<double>().swap(storage);
+	mapping = nullptr;
+	mappingSize = 0;
+	values = nullptr;
+	n = 0;
+}
+
+/**
+ * Returns whether `c` delimits coordinates in text input files.
+ */
+inline bool isDelimiter(char c)
+{
+	return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+/**
+ * Parses the coordinates of the line starting at `c` (and ending before `end`) into `row`, returning the start of the
+ * next line, or `nullptr` if the line is malformed.
+ */
+const char* parseLine(const char* c, const char* end, std::vector<double>& row)
+{
+	row.clear();
+
+	while (c < end && *c != '\n')
+	{
+		if (isDelimiter(*c))
+		{
+			++c;
+			continue;
+		}
+
+		// std::from_chars doesn't accept an explicit positive sign.
+		if (*c == '+')
+			++c;
+
+		double value;
+		std::from_chars_result result = std::from_chars(c, end, value);
+		if (result.ec != std::errc() || (result.ptr < end && !isDelimiter(*result.ptr) && *result.ptr != '\n'))
+			return nullptr;
+
+		row.push_back(value);
+		c = result.ptr;
+	}
+
+	return (c < end) ? c + 1 : end;
+}
+
+/**
+ * Coordinates parsed from a chunk of a text input file.
+ */
+struct Chunk
+{
+	/**
+	 * Start & end of the chunk.
+	 */
+	const char* start;
+	const char* end;
+
+	/**
+	 * Coordinates of each dimension.
+	 */
+	std::vector<std::vector<double>> columns;
+
+	/**
+	 * Start of the first line that couldn't be parsed, if any.
+	 */
+	const char* error = nullptr;
+
+	/**
+	 * Number of coordinates found on the line at `error`.
+	 */
+	size_t errorColumns = 0;
+};
+
+/**
+ * Parses the lines of `chunk`, each of which is expected to have `d` coordinates.
+ */
+void parseChunk(Chunk& chunk, size_t d)
+{
+	chunk.columns.resize(d);
+
+	std::vector<double> row;
+	const char* c = chunk.start;
+
+	while (c < chunk.end)
+	{
+		const char* next = parseLine(c, chunk.end, row);
+
+		// Skip blank lines.
+		if (next != nullptr && row.empty())
+		{
+			c = next;
+			continue;
+		}
+
+		if (next == nullptr || row.size() != d)
+		{
+			chunk.error = c;
+			chunk.errorColumns = (next == nullptr) ? 0 : row.size();
+			return;
+		}
+
+		for (size_t j = 0; j < d; j++)
+			chunk.columns[j].push_back(row[j]);
+
+		c = next;
+	}
+}
+
+/**
+ * Reads the binary input file `path` (of `size` bytes, open as `fd`) into `dataset` by memory-mapping it.
+ */
+bool loadBinary(const char* path, int fd, size_t size, Dataset& dataset)
+{
+	if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+	{
+		std::cerr << "Binary input files are only supported on little-endian hosts." << std::endl;
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		std::cerr << "Failed to map " << path << " into memory." << std::endl;
+		return false;
+	}
+
+	BinaryHeader header = {};
+	memcpy(&header, mapping, std::min(size, sizeof(BinaryHeader)));
+
+	if (!isValidHeader(header, size) || header.n > INT_MAX)
+	{
+		std::cerr << path << ": Malformed binary header." << std::endl;
+		munmap(mapping, size);
+		return false;
+	}
+
+	madvise(mapping, size, MADV_SEQUENTIAL);
+
+	dataset.mapping = mapping;
+	dataset.mappingSize = size;
+	dataset.n = header.n;
+	dataset.d = header.d;
+	dataset.values = (const double*)((const char*)mapping + sizeof(BinaryHeader));
+	return true;
+}
+
+/**
+ * Reads the text input file `path` (of `size` bytes, open as `fd`) into `dataset`, parsing chunks of it with up to
+ * `threads` threads.
+ */
+bool loadText(const char* path, int fd, size_t size, Dataset& dataset, int threads)
+{
+	if (size == 0)
+	{
+		dataset.n = 0;
+		dataset.d = 1;
+		return true;
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		std::cerr << "Failed to map " << path << " into memory." << std::endl;
+		return false;
+	}
+
+	madvise(mapping, size, MADV_SEQUENTIAL);
+
+	const char* start = (const char*)mapping;
+	const char* end = start + size;
+
+	// Determine the number of dimensions from the first non-blank line.
+	std::vector<double> row;
+	for (const char* c = start; c != nullptr && c < end && row.empty(); )
+		c = parseLine(c, end, row);
+
+	size_t d = std::max<size_t>(row.size(), 1);
+
+	// Split the file into chunks at line boundaries, & parse each on its own thread.
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::max<size_t>(1, std::min<size_t>(threads, size / MIN_CHUNK_SIZE));
+
+	std::vector<Chunk> chunks(threads);
+	for (int t = 0; t < threads; t++)
+	{
+		chunks[t].start = (t == 0) ? start : chunks[t - 1].end;
+		chunks[t].end = (t == threads - 1) ? end : std::max(chunks[t].start, start + size / threads * (t + 1));
+
+		const char* newline = (const char*)memchr(chunks[t].end, '\n', end - chunks[t].end);
+		if (t != threads - 1)
+			chunks[t].end = (newline == nullptr) ? end : newline + 1;
+	}
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back(parseChunk, std::ref(chunks[t]), d);
+	parseChunk(chunks[0], d);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// Report the first line that couldn't be parsed.
+	for (const Chunk& chunk : chunks)
+	{
+		if (chunk.error != nullptr)
+		{
+			long lineNumber = 1 + std::count(start, chunk.error, '\n');
+
+			if (chunk.errorColumns == 0)
+				std::cerr << path << ':' << lineNumber << ": Malformed value." << std::endl;
+			else
+				std::cerr << path << ':' << lineNumber << ": Expected " << d << " values, but found "
+					<< chunk.errorColumns << '.' << std::endl;
+
+			munmap(mapping, size);
+			return false;
+		}
+	}
+
+	// Concatenate the columns of each chunk into a structure of arrays.
+	size_t n = 0;
+	for (const Chunk& chunk : chunks)
+		n += chunk.columns[0].size();
+
+	// The number of points must fit `Dataset::n`, as checked for binary files.
+	if (n > INT_MAX)
+	{
+		std::cerr << path << ": Too many values; at most " << INT_MAX << " can be clustered." << std::endl;
+		munmap(mapping, size);
+		return false;
+	}
+
+	dataset.storage.resize(n * d);
+
+	size_t offset = 0;
+	for (const Chunk& chunk : chunks)
+	{
+		for (size_t j = 0; j < d; j++)
+			std::copy(chunk.columns[j].begin(), chunk.columns[j].end(), dataset.storage.begin() + j * n + offset);
+		offset += chunk.columns[0].size();
+	}
+
+	munmap(mapping, size);
+
+	dataset.n = n;
+	dataset.d = d;
+	dataset.values = dataset.storage.data();
+	return true;
+}
+
+/**
+ * Size of the buffer of text read at a time by `PointStream`.
+ */
+const size_t STREAM_BUFFER_SIZE = 1 << 20;
+
+PointStream::~PointStream()
+{
+	if (fd >= 0)
+		close(fd);
+}
+
+bool PointStream::open(const char* path)
+{
+	this->path = path;
+
+	fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "Failed to open " << path << " for reading values." << std::endl;
+		return false;
+	}
+
+	BinaryHeader header;
+	isBinary = pread(fd, &header, sizeof(BinaryHeader), 0) == sizeof(BinaryHeader)
+		&& memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+
+	if (isBinary)
+	{
+		struct stat st;
+		if (fstat(fd, &st) != 0 || !isValidHeader(header, st.st_size))
+		{
+			std::cerr << path << ": Malformed binary header." << std::endl;
+			return false;
+		}
+
+		d = header.d;
+		binaryN = header.n;
+	}
+	else
+	{
+		// Determine the number of dimensions from the first non-blank line.
+		std::vector<double> row;
+		int result;
+		while ((result = readLine(row)) == 1 && row.empty());
+
+		if (result == -1)
+			return false;
+
+		d = std::max<size_t>(row.size(), 1);
+	}
+
+	rewind();
+	return true;
+}
+
+void PointStream::rewind()
+{
+	position = 0;
+	bufferStart = 0;
+	bufferEnd = 0;
+	lineNumber = 0;
+}
+
+int PointStream::readLine(std::vector<double>& row)
+{
+	while (true)
+	{
+		// Parse the next complete line in the buffer.
+		const char* start = buffer.data() + bufferStart;
+		const char* end = buffer.data() + bufferEnd;
+		const char* newline = (const char*)memchr(start, '\n', end - start);
+
+		// Read more text if there's no complete line in the buffer, unless at the end of the file.
+		if (newline == nullptr)
+		{
+			if (bufferStart > 0)
+			{
+				std::copy(buffer.begin() + bufferStart, buffer.begin() + bufferEnd, buffer.begin());
+				bufferEnd -= bufferStart;
+				bufferStart = 0;
+			}
+
+			if (buffer.size() - bufferEnd < STREAM_BUFFER_SIZE)
+				buffer.resize(bufferEnd + STREAM_BUFFER_SIZE);
+
+			ssize_t bytes = pread(fd, buffer.data() + bufferEnd, buffer.size() - bufferEnd, position);
+			if (bytes > 0)
+			{
+				position += bytes;
+				bufferEnd += bytes;
+				continue;
+			}
+
+			if (bufferStart == bufferEnd)
+				return 0;
+
+			// Parse the remainder of the file as the last line.
+			start = buffer.data() + bufferStart;
+			end = buffer.data() + bufferEnd;
+		}
+
+		++lineNumber;
+
+		const char* lineEnd = (newline == nullptr) ? end : newline;
+		const char* next = parseLine(start, lineEnd, row);
+		bufferStart = (newline == nullptr) ? bufferEnd : (newline + 1 - buffer.data());
+
+		if (next == nullptr)
+		{
+			std::cerr << path << ':' << lineNumber << ": Malformed value." << std::endl;
+			return -1;
+		}
+
+		return 1;
+	}
+}
+
+int PointStream::read(int count, std::vector<double>& values)
+{
+	if (isBinary)
+	{
+		// Read the next points of each dimension directly.
+		int read = std::min<size_t>(count, binaryN - position);
+		values.resize((size_t)read * d);
+
+		for (int j = 0; j < d; j++)
+		{
+			off_t offset = sizeof(BinaryHeader) + ((size_t)j * binaryN + position) * sizeof(double);
+			size_t bytes = (size_t)read * sizeof(double);
+			if (pread(fd, values.data() + (size_t)j * read, bytes, offset) != (ssize_t)bytes)
+			{
+				std::cerr << "Failed to read " << path << '.' << std::endl;
+				return -1;
+			}
+		}
+
+		position += read;
+		return read;
+	}
+
+	// Parse lines into rows, then transpose them into a structure of arrays.
+	std::vector<double> rows;
+	std::vector<double> row;
+	int read = 0;
+
+	while (read < count)
+	{
+		int result = readLine(row);
+		if (result == -1)
+			return -1;
+		if (result == 0)
+			break;
+
+		// Skip blank lines.
+		if (row.empty())
+			continue;
+
+		if ((int)row.size() != d)
+		{
+			std::cerr << path << ':' << lineNumber << ": Expected " << d << " values, but found " << row.size() << '.'
+				<< std::endl;
+			return -1;
+		}
+
+		rows.insert(rows.end(), row.begin(), row.end());
+		++read;
+	}
+
+	values.resize((size_t)read * d);
+	for (int i = 0; i < read; i++)
+	{
+		for (int j = 0; j < d; j++)
+			values[(size_t)j * read + i] = rows[(size_t)i * d + j];
+	}
+
+	return read;
+}
+
+bool isBinaryInput(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	char magic[sizeof(BINARY_MAGIC)] = {};
+	bool isBinary = pread(fd, magic, sizeof(magic), 0) == sizeof(magic)
+		&& memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+
+	close(fd);
+	return isBinary;
+}
+
+bool loadPoints(const char* path, Dataset& dataset, int threads)
+{
+	dataset.clear();
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "Failed to open " << path << " for reading values." << std::endl;
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		std::cerr << "Failed to determine the size of " << path << '.' << std::endl;
+		close(fd);
+		return false;
+	}
+
+	size_t size = st.st_size;
+
+	// Detect binary input files by their magic bytes.
+	char magic[sizeof(BINARY_MAGIC)] = {};
+	bool isBinary = size >= sizeof(BinaryHeader)
+		&& pread(fd, magic, sizeof(magic), 0) == sizeof(magic)
+		&& memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+
+	bool loaded = isBinary ? loadBinary(path, fd, size, dataset) : loadText(path, fd, size, dataset, threads);
+
+	// Mappings remain valid once the file is closed.
+	close(fd);
+	return loaded;
+}
@@ -0,0 +1,227 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "points.h"
+#include "timings.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+#endif
+
+/**
+ * Header of binary input files, followed by the coordinates of all points as little-endian `double`s, stored as a
+ * structure of arrays (see `Points`) with a stride of `n`.
+ */
+struct BinaryHeader
+{
+	/**
+	 * Identifies binary input files; always `BINARY_MAGIC`.
+	 */
+	char magic[8];
+
+	/**
+	 * Number of dimensions of each point.
+	 */
+	uint32_t d;
+
+	/**
+	 * Size of each coordinate in bytes; always `sizeof(double)`.
+	 */
+	uint32_t valueSize;
+
+	/**
+	 * Number of points.
+	 */
+	uint64_t n;
+};
+
+/**
+ * Magic bytes at the start of binary input files.
+ */
+extern const char BINARY_MAGIC[8];
+
+/**
+ * Returns whether `header` describes a binary input file of `size` bytes: coordinates of `sizeof(double)` bytes, & a
+ * number of dimensions (within `INT_MAX`) & points that account for every byte after the header.
+ */
+bool isValidHeader(const BinaryHeader& header, uint64_t size);
+
+/**
+ * Points read by `loadPoints`, along with the memory backing them: either a buffer owned by the dataset (for text input
+ * files), or a read-only memory mapping of the input file itself (for binary input files).
+ */
+struct Dataset
+{
+	/**
+	 * Number of points.
+	 */
+	int n = 0;
+
+	/**
+	 * Number of dimensions of each point.
+	 */
+	int d = 1;
+
+	/**
+	 * Coordinates of the points, within either `storage` or `mapping`.
+	 */
+	const double* values = nullptr;
+
+	/**
+	 * Buffer holding coordinates parsed from a text input file.
+	 */
+	std::vector<double> storage;
+
+	/**
+	 * Memory mapping of a binary input file, if any.
+	 */
+	void* mapping = nullptr;
+
+	/**
+	 * Size of `mapping` in bytes.
+	 */
+	size_t mappingSize = 0;
+
+	Dataset() = default;
+	Dataset(const Dataset&) = delete;
+	Dataset& operator=(const Dataset&) = delete;
+	~Dataset();
+
+	/**
+	 * Returns a view of the points.
+	 */
+	Points points() const;
+
+	/**
+	 * Releases the memory backing the points.
+	 */
+	void clear();
+};
+
+/**
+ * Reads points from the file at `path` into `dataset`.
+ *
+ * Files starting with `BINARY_MAGIC` are treated as binary (see `BinaryHeader`), and memory-mapped rather than copied.
+ * Other files are treated as text, with one point per line and coordinates delimited by whitespace or commas; these are
+ * split into chunks at line boundaries and parsed in parallel by up to `threads` threads (or one per hardware thread,
+ * if not positive).
+ *
+ * Returns whether the file was read; writes the reason to `std::cerr` otherwise.
+ */
+bool loadPoints(const char* path, Dataset& dataset, int threads = 0);
+
+/**
+ * Reads points from an input file (in either format accepted by `loadPoints`) in chunks, such that no more than a chunk
+ * of points is held in memory at a time.
+ */
+struct PointStream
+{
+	/**
+	 * Number of dimensions of each point.
+	 */
+	int d = 1;
+
+	PointStream() = default;
+	PointStream(const PointStream&) = delete;
+	PointStream& operator=(const PointStream&) = delete;
+	~PointStream();
+
+	/**
+	 * Opens the file at `path`, determining its format & the number of dimensions of its points. Returns whether the
+	 * file was opened; writes the reason to `std::cerr` otherwise.
+	 */
+	bool open(const char* path);
+
+	/**
+	 * Reads up to `count` subsequent points into `values`, as a structure of arrays with a stride of the number of points
+	 * read, which is returned. Returns 0 once every point was read, or -1 if the file is malformed (writing the reason to
+	 * `std::cerr`).
+	 */
+	int read(int count, std::vector<double>& values);
+
+	/**
+	 * Restarts reading from the first point.
+	 */
+	void rewind();
+
+private:
+	/**
+	 * Path & descriptor of the open file.
+	 */
+	const char* path = nullptr;
+	int fd = -1;
+
+	/**
+	 * Whether the file is binary, & the number of points it holds if so.
+	 */
+	bool isBinary = false;
+	size_t binaryN = 0;
+
+	/**
+	 * Number of points read since the file was opened or rewound (binary files), or number of bytes read (text files).
+	 */
+	size_t position = 0;
+
+	/**
+	 * Buffer of text read from the file but not yet parsed, spanning `[bufferStart, bufferEnd)`.
+	 */
+	std::vector<char> buffer;
+	size_t bufferStart = 0;
+	size_t bufferEnd = 0;
+
+	/**
+	 * Number of the last line parsed.
+	 */
+	long lineNumber = 0;
+
+	/**
+	 * Reads the next line of a text file into `row`, returning 1 if read, 0 at the end of the file, or -1 if the line is
+	 * malformed.
+	 */
+	int readLine(std::vector<double>& row);
+};
+
+/**
+ * Returns whether the file at `path` starts with `BINARY_MAGIC`.
+ */
+bool isBinaryInput(const char* path);
+
+#ifdef CLUSTER_MPI
+/**
+ * Reads the points local to this process of `comm` from the binary input file at `path` (see `BinaryHeader`) with
+ * MPI-IO collective reads, such that no process reads more than its own slice. Points are partitioned with `partition`
+ * according to the number of points derived from the file size, and stored into `values` as a structure of arrays with
+ * a stride of the number of local points. Sets `n` and `d` to the total number of points and their dimensions.
+ *
+ * Must be called by every process of `comm`. Returns whether the file was read (by every process); the root process
+ * writes the reason to `std::cerr` otherwise.
+ */
+bool loadPointsParallel(const char* path, MPI_Comm comm, std::vector<double>& values, int& n, int& d);
+
+/**
+ * Loads the points of the input file at `path`, and distributes them across the processes of `comm` (a group of
+ * `MPI_COMM_WORLD`), each of which receives its partition (see `partition`) into `values` as a structure of arrays with
+ * a stride of the number of local points. `counts` and `displacements` receive the partition of points across `comm`;
+ * `n` and `d` the total number of points and their dimensions; and `timings` the time taken to read (`Phase::Load`)
+ * & distribute (`Phase::Scatter`) the file.
+ *
+ * Binary files are read in parallel by the processes of each group with `loadPointsParallel`. Other files are read by
+ * the root of `MPI_COMM_WORLD`, broadcast to the roots of the other groups across `roots` (the communicator of the
+ * roots of every group; `MPI_COMM_NULL` at other processes), and scattered within each group. Points are printed by
+ * the root if `verbose`.
+ *
+ * Must be called by every process. Returns whether the file was read (by every group); the root process writes the
+ * reason to `std::cerr` otherwise.
+ */
+bool loadPartition(
+	const char* path, MPI_Comm comm, MPI_Comm roots, bool verbose,
+	std::vector<double>& values, int& n, int& d, std::vector<int>& counts, std::vector<int>& displacements,
+	Timings& timings
+);
+#endif
+
+#endif
@@ -0,0 +1,188 @@
+#ifdef CLUSTER_MPI
+
+#include <iostream>
+#include <limits.h>
+#include <string.h>
+
+#include "loader.h"
+#include "util.h"
+
+bool loadPointsParallel(const char* path, MPI_Comm comm, std::vector<double>& values, int& n, int& d)
+{
+	int mpiRank;
+	int mpiSize;
+	MPI_Comm_rank(comm, &mpiRank);
+	MPI_Comm_size(comm, &mpiSize);
+
+	bool isRoot = (mpiRank == 0);
+
+	MPI_File f;
+	if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &f) != MPI_SUCCESS)
+	{
+		if (isRoot)
+			std::cerr << "Failed to open " << path << " for reading values." << std::endl;
+		return false;
+	}
+
+	// Every process reads the header, & derives the number of points from the file size.
+	BinaryHeader header;
+	MPI_Offset size;
+	MPI_File_read_at_all(f, 0, &header, sizeof(BinaryHeader), MPI_BYTE, MPI_STATUS_IGNORE);
+	MPI_File_get_size(f, &size);
+
+	if (memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 || size < 0 || !isValidHeader(header, size)
+		|| header.n > INT_MAX)
+	{
+		if (isRoot)
+			std::cerr << path << ": Malformed binary header." << std::endl;
+
+		MPI_File_close(&f);
+		return false;
+	}
+
+	n = header.n;
+	d = header.d;
+
+	// Read the local slice of each dimension.
+	std::vector<int> counts(mpiSize);
+	std::vector<int> displacements(mpiSize);
+	partition(n, mpiSize, counts.data(), displacements.data());
+
+	int count = counts[mpiRank];
+	values.resize((size_t)count * d);
+
+	int failed = 0;
+	for (int j = 0; j < d; j++)
+	{
+		MPI_Offset offset = sizeof(BinaryHeader) + ((MPI_Offset)j * n + displacements[mpiRank]) * sizeof(double);
+		if (MPI_File_read_at_all(f, offset, values.data() + (size_t)j * count, count, MPI_DOUBLE, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+			failed = 1;
+	}
+
+	MPI_File_close(&f);
+
+	// Succeed only if every process read its slice.
+	MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, comm);
+
+	if (failed && isRoot)
+		std::cerr << "Failed to read " << path << '.' << std::endl;
+
+	return !failed;
+}
+
+bool loadPartition(
+	const char* path, MPI_Comm comm, MPI_Comm roots, bool verbose,
+	std::vector<double>& values, int& n, int& d, std::vector<int>& counts, std::vector<int>& displacements,
+	Timings& timings
+)
+{
+	int mpiRank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+	int groupRank;
+	int groupSize;
+	MPI_Comm_rank(comm, &groupRank);
+	MPI_Comm_size(comm, &groupSize);
+
+	bool isRoot = (mpiRank == 0);
+
+	// Binary input files are read in parallel, with each process reading its own slice; other files are read at the
+	// root & distributed.
+	int isBinary = isRoot && isBinaryInput(path);
+	MPI_Bcast(&isBinary, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	Dataset rootDataset;
+	std::vector<double> groupValues;
+	int dims[2] = { -1, 1 };
+	Clock::time_point tPhase = Clock::now();
+
+	if (isBinary)
+	{
+		if (!loadPointsParallel(path, comm, values, dims[0], dims[1]))
+			dims[0] = -1;
+
+		tPhase = timings.lap(Phase::Load, tPhase);
+
+		// Every group must have read the file for any to proceed.
+		MPI_Allreduce(MPI_IN_PLACE, &dims[0], 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+	}
+	else
+	{
+		if (isRoot)
+		{
+			if (loadPoints(path, rootDataset))
+			{
+				tPhase = timings.lap(Phase::Load, tPhase);
+
+				dims[0] = rootDataset.n;
+				dims[1] = rootDataset.d;
+
+				if (verbose)
+				{
+					for (int j = 0; j < dims[1]; j++)
+					{
+						std::cout << "arr[" << j << "] = ";
+						printArr(dims[0], rootDataset.points().dim(j));
+						std::cout << '\n';
+					}
+					std::cout << std::endl;
+				}
+			}
+		}
+
+		// Broadcast number of points & dimensions; a negative number of points signals that reading failed.
+		MPI_Bcast(dims, 2, MPI_INT, 0, MPI_COMM_WORLD);
+	}
+
+	n = dims[0];
+	d = dims[1];
+
+	if (n < 0)
+		return false;
+
+	counts.resize(groupSize);
+	displacements.resize(groupSize);
+	partition(n, groupSize, counts.data(), displacements.data());
+
+	if (isBinary)
+	{
+		timings.lap(Phase::Scatter, tPhase);
+		return true;
+	}
+
+	// Broadcast values read at the root to the roots of other groups, unless there's a single group.
+	const double* groupRootValues = isRoot ? rootDataset.values : nullptr;
+	int rootsSize = 1;
+	if (roots != MPI_COMM_NULL)
+		MPI_Comm_size(roots, &rootsSize);
+
+	if (roots != MPI_COMM_NULL && rootsSize > 1)
+	{
+		if (!isRoot)
+		{
+			groupValues.resize((size_t)n * d);
+			groupRootValues = groupValues.data();
+		}
+
+		MPI_Bcast((void*)groupRootValues, n * d, MPI_DOUBLE, 0, roots);
+	}
+
+	// Scatter each dimension of values across the processes of each group
+	values.resize((size_t)counts[groupRank] * d);
+
+	for (int j = 0; j < d; j++)
+	{
+		MPI_Scatterv(
+			groupRank == 0 ? groupRootValues + (size_t)j * n : nullptr, counts.data(), displacements.data(), MPI_DOUBLE,
+			values.data() + (size_t)j * counts[groupRank], counts[groupRank], MPI_DOUBLE,
+			0, comm
+		);
+	}
+
+	// Processes other than the root spend the time it reads the file waiting on the broadcast of dimensions, which is
+	// attributed to distributing values.
+	timings.lap(Phase::Scatter, tPhase);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+#include "minibatch.h"
+#include "loader.h"
+#include "lloyd.h"
+#include "seeding.h"
+#include "util.h"
+#include "writer.h"
+
+KMeansResult minibatchKmeans(Args args)
+{
+	// Batches are read as they're needed, so the time spent reading each is attributed to loading.
+	Timings timings;
+	Clock::time_point tPhase = Clock::now();
+
+	PointStream stream;
+	if (!stream.open(args.inputFile))
+		return { -9 };
+
+	int d = stream.d;
+
+	if (args.k <= 0)
+	{
+		std::cerr << "K must be positive." << std::endl;
+		return { -4 };
+	}
+
+	if (args.batchSize < args.k)
+	{
+		std::cerr << "The batch size must be at least K." << std::endl;
+		return { -12 };
+	}
+
+	// Calculate initial centroids with k-means++ over the first batch.
+	std::vector<double> values;
+	int read = stream.read(args.batchSize, values);
+
+	tPhase = timings.lap(Phase::Load, tPhase);
+
+	if (read < 0)
+		return { -9 };
+
+	if (read == 0)
+	{
+		std::cerr << "No values to cluster." << std::endl;
+		return { -3 };
+	}
+
+	if (args.k > read)
+	{
+		std::cerr << "K must be less than the number of values to cluster." << std::endl;
+		return { -5 };
+	}
+
+	std::mt19937_64 rng(rand());
+	std::vector<double> centroidsBuf(args.k * d);
+	double* centroids = centroidsBuf.data();
+	kmeansPlusPlus(Points{ read, d, read, values.data() }, args.k, centroids, rng);
+	tPhase = timings.lap(Phase::Seed, tPhase);
+
+	// Batch memberships & per-centroid accumulators, reused across batches, & the number of points each centroid was
+	// moved towards so far.
+	std::vector<int> memberships(args.batchSize, -1);
+	std::vector<double> sums(args.k * d);
+	std::vector<double> counts(args.k);
+	std::vector<double> totals(args.k, 0.0);
+
+	// Streamed inputs may hold more than INT_MAX points.
+	long n = 0;
+
+	for (int pass = 0; pass < args.passes; pass++)
+	{
+		stream.rewind();
+		n = 0;
+
+		while ((read = stream.read(args.batchSize, values)) > 0)
+		{
+			tPhase = timings.lap(Phase::Load, tPhase);
+
+			// Each batch holds different points, so its sums & counts are accumulated from scratch.
+			Points batch = { read, d, read, values.data() };
+			std::fill(memberships.begin(), memberships.end(), -1);
+			std::fill(sums.begin(), sums.end(), 0.0);
+			std::fill(counts.begin(), counts.end(), 0.0);
+			assignAndAccumulate(batch, args.k, centroids, memberships.data(), sums.data(), counts.data());
+			tPhase = timings.lap(Phase::Assign, tPhase);
+
+			// Move each centroid towards the mean of its members in the batch, by the fraction of all points assigned to
+			// it so far that are in the batch.
+			for (int c = 0; c < args.k; c++)
+			{
+				if (counts[c] == 0)
+					continue;
+
+				totals[c] += counts[c];
+				double rate = counts[c] / totals[c];
+
+				for (int j = 0; j < d; j++)
+					centroids[c * d + j] += rate * (sums[c * d + j] / counts[c] - centroids[c * d + j]);
+			}
+
+			n += read;
+			tPhase = timings.lap(Phase::Reduce, tPhase);
+		}
+
+		tPhase = timings.lap(Phase::Load, tPhase);
+
+		if (read < 0)
+			return { -9 };
+
+		if (pass == 0)
+		{
+			std::cout << "n = " << n << std::endl;
+			std::cout << "d = " << d << std::endl;
+			std::cout << "k = " << args.k << std::endl;
+		}
+
+		// Output pass data
+		if (args.verbose)
+		{
+			std::cout << "centroids = ";
+			printArr(args.k * d, centroids);
+			std::cout << '\n' << std::endl;
+		}
+
+		tPhase = Clock::now();
+	}
+
+	// Compute memberships (& hence inertia) in a final pass, writing them as they're computed.
+	double inertia = -1;
+
+	if (args.membershipOutputFile != nullptr)
+	{
+		std::ofstream f(args.membershipOutputFile, std::ios::binary);
+		if (!f.is_open())
+		{
+			std::cerr << "Failed to open " << args.membershipOutputFile << " for writing memberships" << std::endl;
+			return { -6 };
+		}
+
+		inertia = 0;
+		std::vector<char> buffer;
+
+		stream.rewind();
+		tPhase = Clock::now();
+
+		while ((read = stream.read(args.batchSize, values)) > 0)
+		{
+			tPhase = timings.lap(Phase::Load, tPhase);
+
+			Points batch = { read, d, read, values.data() };
+			assignAndAccumulate(batch, args.k, centroids, memberships.data());
+			inertia += computeInertia(batch, centroids, memberships.data());
+			tPhase = timings.lap(Phase::Assign, tPhase);
+
+			buffer.clear();
+			formatMemberships(read, memberships.data(), args.outputFormat, buffer);
+			f.write(buffer.data(), buffer.size());
+
+			tPhase = timings.lap(Phase::Write, tPhase);
+		}
+
+		if (read < 0)
+			return { -9 };
+
+		// Writes fail silently (e.g. once the disk is full), leaving the stream failed.
+		f.close();
+		if (f.fail())
+		{
+			std::cerr << "Failed to write memberships to " << args.membershipOutputFile << std::endl;
+			return { -6 };
+		}
+
+		std::cout << "Wrote memberships to " << args.membershipOutputFile << std::endl;
+	}
+
+	return { 0, true, n, d, {}, std::move(centroidsBuf), timings, inertia };
+}
@@ -0,0 +1,19 @@
+#ifndef MINIBATCH_H
+#define MINIBATCH_H
+
+#include "kmeans.h"
+
+/**
+ * Executes mini-batch k-means for `args`, streaming points from the input file in batches of `args.batchSize` points,
+ * such that memory use is bounded by the batch size rather than the number of points.
+ *
+ * Centroids are seeded with k-means++ over the first batch, then, for `args.passes` passes over the input, moved
+ * towards the mean of their members in each batch with a per-centroid learning rate that decays with the number of
+ * points assigned to the centroid so far. Memberships are computed in a final pass, and written to
+ * `args.membershipOutputFile` (if any) as they're computed; hence, the result holds no memberships.
+ *
+ * As batches are read in file order, the input should be in random order (e.g. not grouped by cluster).
+ */
+KMeansResult minibatchKmeans(Args args);
+
+#endif
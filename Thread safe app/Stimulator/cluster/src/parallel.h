@@ -0,0 +1,44 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef CLUSTER_OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Calls `fn` with each index of `[0, count)`, across up to `threads` threads; OpenMP threads in the OpenMP builds, and
+ * `std::thread`s otherwise.
+ */
+template<typename F>
+void parallelFor(int count, int threads, const F& fn)
+{
+	threads = std::max(1, std::min(threads, count));
+
+#ifdef CLUSTER_OPENMP
+	#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+	for (int i = 0; i < count; i++)
+		fn(i);
+#else
+	std::atomic<int> next(0);
+	auto work = [&]()
+	{
+		for (int i = next++; i < count; i = next++)
+			fn(i);
+	};
+
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; t++)
+		pool.emplace_back(work);
+
+	work();
+	for (std::thread& t : pool)
+		t.join();
+#endif
+}
+
+#endif
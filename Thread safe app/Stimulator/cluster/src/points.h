@@ -0,0 +1,96 @@
+#ifndef POINTS_H
+#define POINTS_H
+
+#include <stddef.h>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Read-only view of `n` points of `d` dimensions each, with coordinates of type `T`, stored as a structure of arrays:
+ * coordinate `j` of point `i` is at `values[j * stride + i]`. Keeping the coordinates of each dimension contiguous lets
+ * distance computations vectorize across points.
+ */
+template<typename T>
+struct BasicPoints
+{
+	/**
+	 * Number of points.
+	 */
+	int n = 0;
+
+	/**
+	 * Number of dimensions of each point.
+	 */
+	int d = 1;
+
+	/**
+	 * Distance between the first coordinates of consecutive dimensions.
+	 */
+	int stride = 0;
+
+	/**
+	 * Coordinates of the points.
+	 */
+	const T* values = nullptr;
+
+	/**
+	 * Weight of each point, i.e. how many values it stands for (see `aggregatePoints`); every point weighs 1 if null.
+	 */
+	const double* weights = nullptr;
+
+	/**
+	 * Returns the weight of point `i`.
+	 */
+	double weight(int i) const
+	{
+		return weights == nullptr ? 1 : weights[i];
+	}
+
+	/**
+	 * Returns the coordinates of dimension `j` of each point.
+	 */
+	const T* dim(int j) const
+	{
+		return values + (size_t)j * stride;
+	}
+
+	/**
+	 * Returns a view of the `count` points starting at point `start`.
+	 */
+	BasicPoints slice(int start, int count) const
+	{
+		return { count, d, stride, values + start, weights == nullptr ? nullptr : weights + start };
+	}
+};
+
+/**
+ * Points of double precision coordinates, in which values are read & centroids computed.
+ */
+typedef BasicPoints<double> Points;
+
+/**
+ * Returns a view of `points` with coordinates of type `T`: `points` itself if `T` is `double`, or otherwise a copy of
+ * its coordinates (converted to `T`) into `values`, with a stride of `points.n`.
+ */
+template<typename T>
+BasicPoints<T> convertPoints(const Points& points, std::vector<T>& values)
+{
+	if constexpr (std::is_same_v<T, double>)
+	{
+		return points;
+	}
+	else
+	{
+		values.resize((size_t)points.n * points.d);
+		for (int j = 0; j < points.d; j++)
+		{
+			const double* dim = points.dim(j);
+			for (int i = 0; i < points.n; i++)
+				values[(size_t)j * points.n + i] = (T)dim[i];
+		}
+
+		return { points.n, points.d, points.n, values.data(), points.weights };
+	}
+}
+
+#endif
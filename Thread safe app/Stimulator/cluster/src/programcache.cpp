@@ -0,0 +1,129 @@
+#ifdef CLUSTER_MODE_MPI_OPENCL
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <unistd.h>
+
+#include "programcache.h"
+
+/**
+ * Computes the 64-bit FNV-1a hash of `str`.
+ */
+static uint64_t fnv1a(const std::string& str)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : str)
+	{
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/**
+ * Retrieves the path of the cached binary of `source` built for `device` with `options`.
+ */
+static std::string getCachePath(
+	const cl::Device& device, const std::string& source, const std::string& options, const std::string& sourcePath
+)
+{
+	std::string deviceName;
+	device.getInfo(CL_DEVICE_NAME, &deviceName);
+	std::string driverVersion;
+	device.getInfo(CL_DRIVER_VERSION, &driverVersion);
+
+	// Separate parts of the key with a NUL, such that e.g. names ending in digits can't collide with versions.
+	uint64_t hash = fnv1a(deviceName + '\0' + driverVersion + '\0' + options + '\0' + source);
+
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return sourcePath + '.' + key + ".bin";
+}
+
+/**
+ * Loads the program binary at `path` for `device`, returning whether it was loaded & built with `options`.
+ */
+static bool loadBinary(
+	const cl::Context& ctx, const cl::Device& device, const std::string& path, const std::string& options,
+	cl::Program& program
+)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<unsigned char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (binary.empty())
+		return false;
+
+	cl_device_id deviceId = device();
+	const unsigned char* data = binary.data();
+	size_t size = binary.size();
+	cl_int binaryStatus = CL_SUCCESS;
+	cl_int err = CL_SUCCESS;
+
+	cl_program handle = clCreateProgramWithBinary(ctx(), 1, &deviceId, &size, &data, &binaryStatus, &err);
+	if (err != CL_SUCCESS || binaryStatus != CL_SUCCESS)
+		return false;
+
+	// The wrapper takes ownership of the handle, releasing it if the build fails.
+	program = cl::Program(handle);
+	return program.build({ device }, options.c_str()) == CL_SUCCESS;
+}
+
+/**
+ * Writes the binary of `program`, built for a single device, to `path`. Writes go to a temporary file that's then
+ * renamed, such that processes building concurrently never load a partially written binary.
+ */
+static void saveBinary(const cl::Program& program, const std::string& path)
+{
+	size_t size = 0;
+	if (clGetProgramInfo(program(), CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr) != CL_SUCCESS || size == 0)
+		return;
+
+	std::vector<unsigned char> binary(size);
+	unsigned char* data = binary.data();
+	if (clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(data), &data, nullptr) != CL_SUCCESS)
+		return;
+
+	std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+	std::ofstream file(tmpPath, std::ios::binary);
+	if (!file)
+		return;
+
+	file.write((const char*)data, size);
+	file.close();
+
+	if (!file || rename(tmpPath.c_str(), path.c_str()) != 0)
+		remove(tmpPath.c_str());
+}
+
+cl::Program buildProgram(
+	const cl::Context& ctx, const cl::Device& device, const std::string& source, const std::string& options,
+	const std::string& sourcePath, cl_int* err
+)
+{
+	std::string cachePath = getCachePath(device, source, options, sourcePath);
+
+	cl::Program program;
+	if (loadBinary(ctx, device, cachePath, options, program))
+	{
+		*err = CL_SUCCESS;
+		return program;
+	}
+
+	program = cl::Program(ctx, source, false, err);
+	if (*err == CL_SUCCESS)
+		*err = program.build({ device }, options.c_str());
+
+	if (*err == CL_SUCCESS)
+		saveBinary(program, cachePath);
+
+	return program;
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "quality.h"
+#include "parallel.h"
+
+/**
+ * Returns the index of the first of the `n` elements in chunk `chunk` of `chunks` equal chunks.
+ */
+int chunkStart(int n, int chunk, int chunks)
+{
+	return (int)((long)n * chunk / chunks);
+}
+
+void SortedClusters::build(
+	int n, const double* values, const double* weights, const int* memberships, int k, int threads
+)
+{
+	// Bucket members by cluster, then sort & sum each cluster on its own.
+	offsets.assign(k + 1, 0);
+	for (int i = 0; i < n; i++)
+		++offsets[memberships[i] + 1];
+
+	for (int c = 0; c < k; c++)
+		offsets[c + 1] += offsets[c];
+
+	std::vector<std::pair<double, double>> members(n);
+	std::vector<int> next(offsets.begin(), offsets.end() - 1);
+	for (int i = 0; i < n; i++)
+		members[next[memberships[i]]++] = { values[i], weights == nullptr ? 1 : weights[i] };
+
+	this->values.resize(n);
+	this->weights.resize(n);
+	sums.resize(n);
+	means.assign(k, 0);
+	totals.assign(k, 0);
+
+	parallelFor(k, threads, [&](int c)
+	{
+		int start = offsets[c];
+		int end = offsets[c + 1];
+		std::sort(members.begin() + start, members.begin() + end);
+
+		double weight = 0;
+		double sum = 0;
+		for (int i = start; i < end; i++)
+		{
+			weight += members[i].second;
+			sum += members[i].second * members[i].first;
+		}
+
+		means[c] = weight > 0 ? sum / weight : 0;
+		totals[c] = weight;
+
+		weight = 0;
+		sum = 0;
+		for (int i = start; i < end; i++)
+		{
+			double value = members[i].first - means[c];
+			weight += members[i].second;
+			sum += members[i].second * value;
+
+			this->values[i] = value;
+			this->weights[i] = weight;
+			sums[i] = sum;
+		}
+	});
+}
+
+double SortedClusters::totalDistance(int c, double value) const
+{
+	int start = offsets[c];
+	int end = offsets[c + 1];
+	double x = value - means[c];
+
+	// Members up to `i` lie below the value, & those after above it.
+	int i = std::upper_bound(values.begin() + start, values.begin() + end, x) - values.begin();
+	double weightBelow = i > start ? weights[i - 1] : 0;
+	double sumBelow = i > start ? sums[i - 1] : 0;
+	double weightAbove = weights[end - 1] - weightBelow;
+	double sumAbove = sums[end - 1] - sumBelow;
+
+	return std::max(0.0, (x * weightBelow - sumBelow) + (sumAbove - x * weightAbove));
+}
+
+double SortedClusters::silhouette(const Points& points, const int* memberships, int threads, double& weight) const
+{
+	// Order non-empty clusters by their mean.
+	int k = means.size();
+	std::vector<int> order;
+	for (int c = 0; c < k; c++)
+	{
+		if (totals[c] > 0)
+			order.push_back(c);
+	}
+
+	std::sort(order.begin(), order.end(), [this](int l, int r) { return means[l] < means[r]; });
+
+	std::vector<double> orderedMeans(order.size());
+	for (size_t o = 0; o < order.size(); o++)
+		orderedMeans[o] = means[order[o]];
+
+	// Score points in chunks across threads, each summing its own silhouettes & weights.
+	int chunks = std::max(1, threads) * 4;
+	std::vector<double> chunkSums(chunks);
+	std::vector<double> chunkWeights(chunks);
+	const double* dim = points.dim(0);
+
+	parallelFor(chunks, threads, [&](int chunk)
+	{
+		int end = chunkStart(points.n, chunk + 1, chunks);
+		for (int i = chunkStart(points.n, chunk, chunks); i < end; i++)
+		{
+			double value = dim[i];
+			int own = memberships[i];
+			double w = points.weight(i);
+			chunkWeights[chunk] += w;
+
+			// A value alone in its cluster (counting its duplicates) scores 0.
+			if (totals[own] <= 1)
+				continue;
+
+			double a = totalDistance(own, value) / (totals[own] - 1);
+
+			// Visit clusters outwards from the value in order of the distance of their mean, a lower bound of their
+			// mean distance.
+			double b = std::numeric_limits<double>::infinity();
+			int above = std::lower_bound(orderedMeans.begin(), orderedMeans.end(), value) - orderedMeans.begin();
+			int below = above - 1;
+
+			while (true)
+			{
+				double distBelow = below >= 0 ? value - orderedMeans[below] : std::numeric_limits<double>::infinity();
+				double distAbove = above < (int)order.size()
+					? orderedMeans[above] - value
+					: std::numeric_limits<double>::infinity();
+
+				double bound = std::min(distBelow, distAbove);
+				if (bound >= b || std::isinf(bound))
+					break;
+
+				int c = distBelow <= distAbove ? order[below--] : order[above++];
+				if (c != own)
+					b = std::min(b, totalDistance(c, value) / totals[c]);
+			}
+
+			double scale = std::max(a, b);
+			if (!std::isinf(b) && scale > 0)
+				chunkSums[chunk] += w * (b - a) / scale;
+		}
+	});
+
+	double sum = 0;
+	for (int chunk = 0; chunk < chunks; chunk++)
+	{
+		sum += chunkSums[chunk];
+		weight += chunkWeights[chunk];
+	}
+
+	return sum;
+}
+
+void accumulateDistances(
+	const Points& points, int k, const double* centroids, const int* memberships, int threads,
+	double* distances, double* weights
+)
+{
+	int d = points.d;
+	int chunks = std::max(1, threads);
+	std::vector<double> chunkDistances((size_t)chunks * k);
+	std::vector<double> chunkWeights((size_t)chunks * k);
+
+	parallelFor(chunks, threads, [&](int chunk)
+	{
+		double* localDistances = chunkDistances.data() + (size_t)chunk * k;
+		double* localWeights = chunkWeights.data() + (size_t)chunk * k;
+
+		int end = chunkStart(points.n, chunk + 1, chunks);
+		for (int i = chunkStart(points.n, chunk, chunks); i < end; i++)
+		{
+			int c = memberships[i];
+			double acc = 0;
+			for (int j = 0; j < d; j++)
+			{
+				double diff = points.dim(j)[i] - centroids[c * d + j];
+				acc += diff * diff;
+			}
+
+			localDistances[c] += points.weight(i) * std::sqrt(acc);
+			localWeights[c] += points.weight(i);
+		}
+	});
+
+	for (int chunk = 0; chunk < chunks; chunk++)
+	{
+		for (int c = 0; c < k; c++)
+		{
+			distances[c] += chunkDistances[(size_t)chunk * k + c];
+			weights[c] += chunkWeights[(size_t)chunk * k + c];
+		}
+	}
+}
+
+double daviesBouldin(int k, int d, const double* centroids, const double* distances, const double* weights)
+{
+	double total = 0;
+	int clusters = 0;
+
+	for (int c = 0; c < k; c++)
+	{
+		if (weights[c] <= 0)
+			continue;
+
+		double scatter = distances[c] / weights[c];
+		double worst = 0;
+
+		for (int o = 0; o < k; o++)
+		{
+			if (o == c || weights[o] <= 0)
+				continue;
+
+			double acc = 0;
+			for (int j = 0; j < d; j++)
+			{
+				double diff = centroids[c * d + j] - centroids[o * d + j];
+				acc += diff * diff;
+			}
+
+			if (acc > 0)
+				worst = std::max(worst, (scatter + distances[o] / weights[o]) / std::sqrt(acc));
+		}
+
+		total += worst;
+		++clusters;
+	}
+
+	return clusters > 0 ? total / clusters : 0;
+}
+
+QualityScores scoreClusters(const Points& points, int k, const double* centroids, const int* memberships, int threads)
+{
+	QualityScores scores;
+
+	std::vector<double> distances(k);
+	std::vector<double> weights(k);
+	accumulateDistances(points, k, centroids, memberships, threads, distances.data(), weights.data());
+	scores.daviesBouldin = daviesBouldin(k, points.d, centroids, distances.data(), weights.data());
+
+	if (points.d == 1)
+	{
+		SortedClusters clusters;
+		clusters.build(points.n, points.dim(0), points.weights, memberships, k, threads);
+
+		double weight = 0;
+		double sum = clusters.silhouette(points, memberships, threads, weight);
+		scores.silhouette = weight > 0 ? sum / weight : 0;
+	}
+
+	return scores;
+}
@@ -0,0 +1,131 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <limits>
+#include <vector>
+
+#include "points.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+#endif
+
+/**
+ * Scores of the quality of clusters besides their inertia, by which the clusters found for different `k` are compared.
+ */
+struct QualityScores
+{
+	/**
+	 * Davies–Bouldin index: the mean, over clusters, of the largest ratio (over other clusters) of the sum of the
+	 * mean distances of the members of both clusters to their centroid over the distance between their centroids.
+	 * Lower is better; negative if not computed.
+	 */
+	double daviesBouldin = -1;
+
+	/**
+	 * Mean silhouette of the values: (b - a) / max(a, b) for each value, where a is its mean distance to the other
+	 * members of its cluster & b its least mean distance to the members of another cluster (0 if its cluster has no
+	 * other members). Within [-1, 1], higher is better; NaN if not computed (i.e. values of more than 1 dimension).
+	 */
+	double silhouette = std::numeric_limits<double>::quiet_NaN();
+};
+
+/**
+ * Members of each cluster of 1-dimensional values, sorted, with prefix sums of their weights & weighted values (about
+ * the mean of the cluster, such that sums stay small enough for distances not to cancel out). The total distance
+ * between any value & the members of a cluster is derived from them in O(log n).
+ */
+struct SortedClusters
+{
+	/**
+	 * Offset of the members of each cluster within `values`, `weights` & `sums`; `k + 1` offsets.
+	 */
+	std::vector<int> offsets;
+
+	/**
+	 * Members of each cluster in ascending order, less the mean of the cluster.
+	 */
+	std::vector<double> values;
+
+	/**
+	 * Total weight of the members of each cluster up to & including each member.
+	 */
+	std::vector<double> weights;
+
+	/**
+	 * Total weighted value (less the mean of the cluster) of the members of each cluster up to & including each member.
+	 */
+	std::vector<double> sums;
+
+	/**
+	 * Mean of the members of each cluster.
+	 */
+	std::vector<double> means;
+
+	/**
+	 * Total weight of the members of each cluster.
+	 */
+	std::vector<double> totals;
+
+	/**
+	 * Sorts the `n` 1-dimensional `values` (weighted by `weights`, if specified) into the `k` clusters of their
+	 * `memberships`, sorting clusters across `threads` threads.
+	 */
+	void build(int n, const double* values, const double* weights, const int* memberships, int k, int threads);
+
+	/**
+	 * Returns the sum of the distances between `value` & each member of non-empty cluster `c` (times its weight).
+	 */
+	double totalDistance(int c, double value) const;
+
+	/**
+	 * Returns the sum of the silhouettes of `points` (times their weight), members of the sorted clusters given their
+	 * `memberships`, across `threads` threads; adds the total weight of `points` to `weight`.
+	 *
+	 * The mean distance of a value to a cluster is at least its distance to the mean of the cluster (& equal if no
+	 * member lies on either side of it), so clusters are visited in order of the distance of their mean, until it
+	 * exceeds the least mean distance found. The clusters of k-means are contiguous in 1 dimension, so that's usually
+	 * once both neighbours of the value's cluster were visited, & each value is scored in O(log n).
+	 */
+	double silhouette(const Points& points, const int* memberships, int threads, double& weight) const;
+};
+
+/**
+ * Adds the (Euclidean) distance between each of the `points` and the centroid of its cluster (times its weight) to
+ * element `memberships[i]` of `distances`, & its weight to that of `weights`, across `threads` threads. `centroids`
+ * holds `k` points of `points.d` dimensions each, stored consecutively; `distances` & `weights` hold `k` values.
+ */
+void accumulateDistances(
+	const Points& points, int k, const double* centroids, const int* memberships, int threads,
+	double* distances, double* weights
+);
+
+/**
+ * Returns the Davies–Bouldin index of the `k` clusters of `d` dimensions of `centroids`, given the total `distances`
+ * between their members & their centroid & the total `weights` of their members (see `accumulateDistances`). Empty
+ * clusters are left out, as are pairs of clusters of the same centroid.
+ */
+double daviesBouldin(int k, int d, const double* centroids, const double* distances, const double* weights);
+
+/**
+ * Scores the clusters of `points` given their `memberships` among the `k` `centroids` (`points.d` consecutive values
+ * per centroid), across `threads` threads. The silhouette is only computed for 1-dimensional values; in O(n log n)
+ * time & O(n) memory.
+ */
+QualityScores scoreClusters(const Points& points, int k, const double* centroids, const int* memberships, int threads);
+
+#ifdef CLUSTER_MPI
+/**
+ * Scores the clusters of `points` partitioned across the processes of `comm` (some of which may hold no points),
+ * given their `memberships` among the `k` `centroids`, across `threads` threads per process. Returns the scores at the
+ * root of `comm`, whose `centroids` are used for the Davies–Bouldin index. Must be called by every process of `comm`.
+ *
+ * The silhouette of each point depends on every other point, so every process gathers all of them (along with their
+ * memberships & weights), & scores its own against them; i.e. O(n) memory per process.
+ */
+QualityScores scoreClustersParallel(
+	const Points& points, int k, const double* centroids, const int* memberships, int threads, MPI_Comm comm
+);
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#ifdef CLUSTER_MPI
+
+#include "quality.h"
+
+QualityScores scoreClustersParallel(
+	const Points& points, int k, const double* centroids, const int* memberships, int threads, MPI_Comm comm
+)
+{
+	int rank;
+	int size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	QualityScores scores;
+
+	// Combine the distances between members & centroids of each cluster on the root.
+	std::vector<double> distances(k * 2);
+	accumulateDistances(points, k, centroids, memberships, threads, distances.data(), distances.data() + k);
+	MPI_Reduce(rank == 0 ? MPI_IN_PLACE : distances.data(), distances.data(), k * 2, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+	if (rank == 0)
+		scores.daviesBouldin = daviesBouldin(k, points.d, centroids, distances.data(), distances.data() + k);
+
+	if (points.d != 1)
+		return scores;
+
+	// Gather every value, membership & weight, & score the local values against the clusters of all of them.
+	std::vector<int> counts(size);
+	std::vector<int> displacements(size);
+	MPI_Allgather(&points.n, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+
+	int n = 0;
+	for (int r = 0; r < size; r++)
+	{
+		displacements[r] = n;
+		n += counts[r];
+	}
+
+	std::vector<double> localWeights(points.n);
+	for (int i = 0; i < points.n; i++)
+		localWeights[i] = points.weight(i);
+
+	std::vector<double> values(n);
+	std::vector<double> weights(n);
+	std::vector<int> allMemberships(n);
+
+	MPI_Allgatherv(
+		points.dim(0), points.n, MPI_DOUBLE, values.data(), counts.data(), displacements.data(), MPI_DOUBLE, comm
+	);
+	MPI_Allgatherv(
+		localWeights.data(), points.n, MPI_DOUBLE, weights.data(), counts.data(), displacements.data(), MPI_DOUBLE, comm
+	);
+	MPI_Allgatherv(
+		memberships, points.n, MPI_INT, allMemberships.data(), counts.data(), displacements.data(), MPI_INT, comm
+	);
+
+	double totals[2] = { 0, 0 };
+	if (points.n > 0)
+	{
+		SortedClusters clusters;
+		clusters.build(n, values.data(), weights.data(), allMemberships.data(), k, threads);
+		totals[0] = clusters.silhouette(points, memberships, threads, totals[1]);
+	}
+
+	MPI_Reduce(rank == 0 ? MPI_IN_PLACE : totals, totals, 2, MPI_DOUBLE, MPI_SUM, 0, comm);
+	scores.silhouette = totals[1] > 0 ? totals[0] / totals[1] : 0;
+
+	return scores;
+}
+
+#endif
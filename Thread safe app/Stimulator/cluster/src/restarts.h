@@ -0,0 +1,34 @@
+#ifdef CLUSTER_MPI
+
+#ifndef RESTARTS_H
+#define RESTARTS_H
+
+#include <mpich/mpi.h>
+
+#include "kmeans.h"
+
+/**
+ * Splits the processes of `MPI_COMM_WORLD` into as many groups as `restarts` (up to one per process) into `group`, such
+ * that each group runs its share of restarts concurrently with the others; restart `r` is run by the group at index
+ * `r % groups`. The roots of the groups are additionally joined into `roots` (`MPI_COMM_NULL` at other processes), of
+ * which the root of `MPI_COMM_WORLD` is the root.
+ *
+ * Sets `groups` to the number of groups, and returns the index of the group of this process.
+ */
+int splitRestarts(int restarts, MPI_Comm& group, MPI_Comm& roots, int& groups);
+
+/**
+ * Frees the communicators created by `splitRestarts`.
+ */
+void freeRestarts(MPI_Comm& group, MPI_Comm& roots);
+
+/**
+ * Selects the best (i.e. lowest inertia) among the `run` of each group, with memberships of `n` values & `size`
+ * centroid values (`n` may be 0 to leave memberships
+ * out), into the `run` of the root of `roots`. Must be called by every process of `roots`.
+ */
+void selectBestRun(KMeansRun& run, int n, int size, MPI_Comm roots);
+
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+#ifdef CLUSTER_MPI
+
+#include <algorithm>
+
+#include "restarts.h"
+
+int splitRestarts(int restarts, MPI_Comm& group, MPI_Comm& roots, int& groups)
+{
+	int mpiRank;
+	int mpiSize;
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+	MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+	groups = std::max(1, std::min(restarts, mpiSize));
+	int index = mpiRank % groups;
+
+	MPI_Comm_split(MPI_COMM_WORLD, index, mpiRank, &group);
+
+	// The lowest ranks are the roots of their groups, ordered by index.
+	MPI_Comm_split(MPI_COMM_WORLD, mpiRank < groups ? 0 : MPI_UNDEFINED, mpiRank, &roots);
+
+	return index;
+}
+
+void freeRestarts(MPI_Comm& group, MPI_Comm& roots)
+{
+	if (roots != MPI_COMM_NULL)
+		MPI_Comm_free(&roots);
+
+	MPI_Comm_free(&group);
+}
+
+void selectBestRun(KMeansRun& run, int n, int size, MPI_Comm roots)
+{
+	int rank;
+	MPI_Comm_rank(roots, &rank);
+
+	struct { double inertia; int rank; } best = { run.inertia, rank };
+	MPI_Allreduce(MPI_IN_PLACE, &best, 1, MPI_DOUBLE_INT, MPI_MINLOC, roots);
+
+	if (best.rank == 0)
+		return;
+
+	// Send the best run to the root, unless it's already there.
+	if (rank == best.rank)
+	{
+		MPI_Send(run.memberships.data(), n, MPI_INT, 0, 0, roots);
+		MPI_Send(run.centroids.data(), size, MPI_DOUBLE, 0, 1, roots);
+		MPI_Send(&run.iterations, 1, MPI_INT, 0, 2, roots);
+	}
+	else if (rank == 0)
+	{
+		MPI_Recv(run.memberships.data(), n, MPI_INT, best.rank, 0, roots, MPI_STATUS_IGNORE);
+		MPI_Recv(run.centroids.data(), size, MPI_DOUBLE, best.rank, 1, roots, MPI_STATUS_IGNORE);
+		MPI_Recv(&run.iterations, 1, MPI_INT, best.rank, 2, roots, MPI_STATUS_IGNORE);
+		run.inertia = best.inertia;
+	}
+}
+
+#endif
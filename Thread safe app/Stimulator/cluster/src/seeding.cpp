@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "seeding.h"
+
+/**
+ * Lowers each of the `minDists` of `points` to the squared distance between the point and `centroid`, if closer.
+ */
+template<typename T>
+void lowerMinDists(const BasicPoints<T>& points, const double* centroid, double* minDists, double* dists)
+{
+	std::fill(dists, dists + points.n, 0.0);
+
+	for (int j = 0; j < points.d; j++)
+	{
+		const T* coordinates = points.dim(j);
+		for (int i = 0; i < points.n; i++)
+		{
+			double diff = coordinates[i] - centroid[j];
+			dists[i] += diff * diff;
+		}
+	}
+
+	for (int i = 0; i < points.n; i++)
+		minDists[i] = std::min(minDists[i], dists[i]);
+}
+
+/**
+ * Returns the index of an element of `probabilities` (of length `n`, summing to `total`) chosen at random with
+ * probability proportional to its value.
+ */
+int sample(int n, const double* probabilities, double total, std::mt19937_64& rng)
+{
+	double r = std::uniform_real_distribution<double>(0, total)(rng);
+	for (int i = 0; i < n; i++)
+	{
+		r -= probabilities[i];
+		if (r < 0)
+			return i;
+	}
+
+	// Guard against rounding errors by returning the last element of non-zero probability.
+	for (int i = n - 1; i > 0; i--)
+	{
+		if (probabilities[i] > 0)
+			return i;
+	}
+	return 0;
+}
+
+template<typename T>
+void kmeansPlusPlus(const BasicPoints<T>& points, int k, double* centroids, std::mt19937_64& rng)
+{
+	int n = points.n;
+	int d = points.d;
+
+	std::vector<double> minDists(n, std::numeric_limits<double>::infinity());
+	std::vector<double> dists(n);
+	std::vector<double> probabilities(n);
+
+	for (int c = 0; c < k; c++)
+	{
+		// Compute the probability of choosing each point.
+		double total = 0;
+		for (int i = 0; i < n; i++)
+		{
+			probabilities[i] = points.weight(i) * (c == 0 ? 1 : minDists[i]);
+			total += probabilities[i];
+		}
+
+		// Choose uniformly if every remaining point coincides with a centroid.
+		int chosen = (total > 0)
+			? sample(n, probabilities.data(), total, rng)
+			: std::uniform_int_distribution<int>(0, n - 1)(rng);
+
+		for (int j = 0; j < d; j++)
+			centroids[c * d + j] = points.dim(j)[chosen];
+
+		lowerMinDists(points, centroids + c * d, minDists.data(), dists.data());
+	}
+}
+
+template void kmeansPlusPlus(const BasicPoints<float>&, int, double*, std::mt19937_64&);
+template void kmeansPlusPlus(const BasicPoints<double>&, int, double*, std::mt19937_64&);
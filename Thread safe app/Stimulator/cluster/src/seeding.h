@@ -0,0 +1,44 @@
+#ifndef SEEDING_H
+#define SEEDING_H
+
+#include <random>
+
+#include "points.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+
+#include "telemetry.h"
+#endif
+
+/**
+ * Chooses `k` initial centroids among `points` with k-means++ seeding, into `centroids` (`points.d` consecutive values
+ * per centroid): the first centroid is chosen at random, and each subsequent one with probability proportional to its
+ * squared distance to the closest centroid chosen so far. If `points` are weighted, probabilities are additionally
+ * proportional to the weight of each point.
+ */
+template<typename T>
+void kmeansPlusPlus(const BasicPoints<T>& points, int k, double* centroids, std::mt19937_64& rng);
+
+#ifdef CLUSTER_MPI
+/**
+ * Chooses `k` initial centroids with scalable k-means++ (k-means||) seeding, into `centroids` (`points.d` consecutive
+ * values per centroid), where `points` are the points local to this process of `comm`. Must be called by every process
+ * of `comm`, each of which ends up with the same centroids.
+ *
+ * For a few rounds, each process samples its points independently with probability proportional to their squared
+ * distance to the closest candidate so far (times their weight, if `points` are weighted), with costs combined across
+ * processes by reduction; the sampled candidates are then weighted by the number (or total weight) of points closest to
+ * them, and reduced to `k` centroids with weighted k-means++.
+ *
+ * Random choices are derived from `seed`, which must be the same on every process of `comm`. The bytes communicated
+ * are added to `traffic`, if specified.
+ */
+template<typename T>
+void kmeansParallel(
+	const BasicPoints<T>& points, int k, double* centroids, MPI_Comm comm, unsigned long seed,
+	Traffic* traffic = nullptr
+);
+#endif
+
+#endif
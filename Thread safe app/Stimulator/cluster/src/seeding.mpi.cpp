@@ -0,0 +1,178 @@
+#ifdef CLUSTER_MPI
+
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "lloyd.h"
+#include "seeding.h"
+
+/**
+ * Number of rounds in which k-means|| samples candidates.
+ */
+const int ROUNDS = 5;
+
+/**
+ * Maximum number of rounds in which k-means|| samples candidates, if fewer than `k` were sampled after `ROUNDS`.
+ */
+const int MAX_ROUNDS = 20;
+
+/**
+ * Lowers each of the `minDists` of `points` to the squared distance between the point and the closest of the `count`
+ * `candidates` (`points.d` consecutive values per candidate), if closer.
+ */
+template<typename T>
+void lowerMinDistsToCandidates(const BasicPoints<T>& points, int count, const double* candidates, double* minDists)
+{
+	for (int i = 0; i < points.n; i++)
+	{
+		for (int c = 0; c < count; c++)
+		{
+			double dist = 0;
+			for (int j = 0; j < points.d; j++)
+			{
+				double diff = points.dim(j)[i] - candidates[c * points.d + j];
+				dist += diff * diff;
+			}
+			minDists[i] = std::min(minDists[i], dist);
+		}
+	}
+}
+
+/**
+ * Returns the sum of the `minDists` of `points`, times their weight.
+ */
+template<typename T>
+double weightedCost(const BasicPoints<T>& points, const double* minDists)
+{
+	double cost = 0;
+	for (int i = 0; i < points.n; i++)
+		cost += points.weight(i) * minDists[i];
+	return cost;
+}
+
+template<typename T>
+void kmeansParallel(
+	const BasicPoints<T>& points, int k, double* centroids, MPI_Comm comm, unsigned long seed, Traffic* traffic
+)
+{
+	int mpiRank;
+	int mpiSize;
+	MPI_Comm_rank(comm, &mpiRank);
+	MPI_Comm_size(comm, &mpiSize);
+
+	int d = points.d;
+
+	// Count the bytes of each collective, whether or not they're reported.
+	Traffic untracked;
+	Traffic& counted = traffic != nullptr ? *traffic : untracked;
+
+	// Seed a generator shared by all processes (for choices they must agree on), & one per process (for sampling).
+	std::mt19937_64 sharedRng(seed);
+	std::seed_seq localSeed = { seed, (unsigned long)mpiRank + 1 };
+	std::mt19937_64 localRng(localSeed);
+
+	// Compute the total number of points, & the offset of local points among them.
+	long localN = points.n;
+	long n = 0;
+	long offset = 0;
+	MPI_Allreduce(&localN, &n, 1, MPI_LONG, MPI_SUM, comm);
+	MPI_Exscan(&localN, &offset, 1, MPI_LONG, MPI_SUM, comm);
+	counted.allreduce(comm, 2 * sizeof(long));
+	if (mpiRank == 0)
+		offset = 0;
+
+	// Choose the first candidate uniformly, & broadcast it from the process it's local to.
+	std::vector<double> candidates(d);
+
+	long first = std::uniform_int_distribution<long>(0, n - 1)(sharedRng);
+	int owner = (first >= offset && first < offset + localN) ? mpiRank : -1;
+	MPI_Allreduce(MPI_IN_PLACE, &owner, 1, MPI_INT, MPI_MAX, comm);
+	counted.allreduce(comm, sizeof(int));
+
+	if (owner == mpiRank)
+	{
+		for (int j = 0; j < d; j++)
+			candidates[j] = points.dim(j)[first - offset];
+	}
+	MPI_Bcast(candidates.data(), d, MPI_DOUBLE, owner, comm);
+	counted.broadcast(comm, owner, sizeof(double) * d);
+
+	// Compute squared distances to the closest candidate, & their (global, weighted) sum.
+	std::vector<double> minDists(points.n, std::numeric_limits<double>::infinity());
+	lowerMinDistsToCandidates(points, 1, candidates.data(), minDists.data());
+
+	double cost = weightedCost(points, minDists.data());
+	MPI_Allreduce(MPI_IN_PLACE, &cost, 1, MPI_DOUBLE, MPI_SUM, comm);
+	counted.allreduce(comm, sizeof(double));
+
+	// Sample ~2k candidates per round, across processes.
+	double oversampling = 2.0 * k;
+	std::vector<int> sampledCounts(mpiSize);
+	std::vector<int> sampledDisplacements(mpiSize);
+
+	for (int round = 0; cost > 0 && (round < ROUNDS || (int)candidates.size() / d < k) && round < MAX_ROUNDS; round++)
+	{
+		std::vector<double> sampled;
+		std::uniform_real_distribution<double> uniform(0, 1);
+
+		for (int i = 0; i < points.n; i++)
+		{
+			if (uniform(localRng) < oversampling * points.weight(i) * minDists[i] / cost)
+			{
+				for (int j = 0; j < d; j++)
+					sampled.push_back(points.dim(j)[i]);
+			}
+		}
+
+		// Share sampled candidates with all processes.
+		int sampledCount = sampled.size();
+		MPI_Allgather(&sampledCount, 1, MPI_INT, sampledCounts.data(), 1, MPI_INT, comm);
+		counted.allgather(comm, sizeof(int));
+
+		std::exclusive_scan(sampledCounts.begin(), sampledCounts.end(), sampledDisplacements.begin(), 0);
+		int total = sampledDisplacements.back() + sampledCounts.back();
+
+		std::vector<double> allSampled(total);
+		MPI_Allgatherv(
+			sampled.data(), sampledCount, MPI_DOUBLE,
+			allSampled.data(), sampledCounts.data(), sampledDisplacements.data(), MPI_DOUBLE,
+			comm
+		);
+		counted.allgatherv(comm, sampledCounts.data(), sizeof(double));
+
+		lowerMinDistsToCandidates(points, total / d, allSampled.data(), minDists.data());
+		candidates.insert(candidates.end(), allSampled.begin(), allSampled.end());
+
+		cost = weightedCost(points, minDists.data());
+		MPI_Allreduce(MPI_IN_PLACE, &cost, 1, MPI_DOUBLE, MPI_SUM, comm);
+		counted.allreduce(comm, sizeof(double));
+	}
+
+	// Weigh each candidate by the (global) number, or total weight, of points closest to it.
+	int candidateCount = candidates.size() / d;
+
+	std::vector<int> memberships(points.n, -1);
+	std::vector<double> sums(candidateCount * d);
+	std::vector<double> weights(candidateCount);
+	assignAndAccumulate(points, candidateCount, candidates.data(), memberships.data(), sums.data(), weights.data());
+
+	MPI_Allreduce(MPI_IN_PLACE, weights.data(), candidateCount, MPI_DOUBLE, MPI_SUM, comm);
+	counted.allreduce(comm, sizeof(double) * candidateCount);
+
+	// Reduce candidates to k centroids with weighted k-means++; identically on each process, given the shared generator.
+	std::vector<double> candidateValues(candidateCount * d);
+	for (int c = 0; c < candidateCount; c++)
+	{
+		for (int j = 0; j < d; j++)
+			candidateValues[j * candidateCount + c] = candidates[c * d + j];
+	}
+
+	Points candidatePoints = { candidateCount, d, candidateCount, candidateValues.data(), weights.data() };
+	kmeansPlusPlus(candidatePoints, k, centroids, sharedRng);
+}
+
+template void kmeansParallel(const BasicPoints<float>&, int, double*, MPI_Comm, unsigned long, Traffic*);
+template void kmeansParallel(const BasicPoints<double>&, int, double*, MPI_Comm, unsigned long, Traffic*);
+
+#endif
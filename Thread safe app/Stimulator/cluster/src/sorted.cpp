@@ -0,0 +1,110 @@
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+#include "sorted.h"
+#include "util.h"
+
+template<typename T>
+int sortedKmeans(
+	int n, const T* arr, const double* weights,
+	int k, double* centroids,
+	int* memberships,
+	double tolerance, int maxIterations,
+	bool verbose
+)
+{
+	// Sort (indices of) values once, & compute their prefix sums (where prefix[i] is the sum of the first i values) &
+	// the prefix sums of their weights.
+	std::vector<int> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [arr](int l, int r) { return arr[l] < arr[r]; });
+
+	std::vector<double> sorted(n);
+	std::vector<double> prefix(n + 1);
+	std::vector<double> prefixWeights(n + 1);
+	prefix[0] = 0;
+	prefixWeights[0] = 0;
+	for (int i = 0; i < n; i++)
+	{
+		double weight = weights == nullptr ? 1 : weights[order[i]];
+		sorted[i] = arr[order[i]];
+		prefix[i + 1] = prefix[i] + weight * sorted[i];
+		prefixWeights[i + 1] = prefixWeights[i] + weight;
+	}
+
+	// Centroids stay sorted across iterations, since the mean of each (ordered) partition lies within it.
+	std::sort(centroids, centroids + k);
+
+	// Centroid i owns the sorted values in [splits[i], splits[i + 1]).
+	std::vector<int> oldSplits(k + 1, -1);
+	std::vector<int> newSplits(k + 1);
+	newSplits[0] = 0;
+	newSplits[k] = n;
+
+	int iterations = 0;
+	while (true)
+	{
+		++iterations;
+
+		// Values up to (& including) the midpoint of adjacent centroids belong to the lower centroid.
+		for (int i = 1; i < k; i++)
+		{
+			double midpoint = (centroids[i - 1] + centroids[i]) / 2;
+			newSplits[i] = std::upper_bound(sorted.begin(), sorted.end(), midpoint) - sorted.begin();
+		}
+
+		if (newSplits == oldSplits)
+			break;
+
+		// Recalculate centroids; empty centroids are left as they are, to keep centroids sorted.
+		double shift = 0;
+		double magnitude = 0;
+
+		for (int i = 0; i < k; i++)
+		{
+			magnitude += centroids[i] * centroids[i];
+
+			double count = prefixWeights[newSplits[i + 1]] - prefixWeights[newSplits[i]];
+			if (count > 0)
+			{
+				double mean = (prefix[newSplits[i + 1]] - prefix[newSplits[i]]) / count;
+				shift += (mean - centroids[i]) * (mean - centroids[i]);
+				centroids[i] = mean;
+			}
+		}
+
+		// Stop early once centroids barely move, keeping the splits (& hence memberships) of this iteration.
+		shift = magnitude > 0 ? std::sqrt(shift / magnitude) : std::sqrt(shift);
+		if (hasConverged(iterations, 1, shift, tolerance, maxIterations))
+			break;
+
+		std::swap(oldSplits, newSplits);
+		newSplits[0] = 0;
+		newSplits[k] = n;
+
+		// Output iteration data
+		if (verbose)
+		{
+			std::cout << "centroids = ";
+			printArr(k, centroids);
+			std::cout << "\nsplits = ";
+			printArr(k + 1, oldSplits.data());
+			std::cout << '\n' << std::endl;
+		}
+	}
+
+	// Populate memberships from the final splits.
+	for (int i = 0; i < k; i++)
+	{
+		for (int j = newSplits[i]; j < newSplits[i + 1]; j++)
+			memberships[order[j]] = i;
+	}
+
+	return iterations;
+}
+
+template int sortedKmeans(int, const float*, const double*, int, double*, int*, double, int, bool);
+template int sortedKmeans(int, const double*, const double*, int, double*, int*, double, int, bool);
@@ -0,0 +1,23 @@
+#ifndef SORTED_H
+#define SORTED_H
+
+/**
+ * Executes Lloyd's algorithm on the `n` values of `arr` (weighted by `weights`, if specified), starting from the `k`
+ * initial `centroids`, populating `memberships` (of length `n`) and `centroids` in the process, until converged (see
+ * `hasConverged`) for `tolerance` and `maxIterations`. Returns the number of iterations executed.
+ *
+ * Values are sorted once and their prefix sums kept, so that each iteration only needs to locate the midpoints
+ * between adjacent centroids (by binary search) and read each centroid's mean off the prefix sums; i.e. an iteration
+ * costs O(k log n) rather than O(k n). `centroids` are sorted in ascending order, and `memberships` refer to them in
+ * that order.
+ */
+template<typename T>
+int sortedKmeans(
+	int n, const T* arr, const double* weights,
+	int k, double* centroids,
+	int* memberships,
+	double tolerance, int maxIterations,
+	bool verbose
+);
+
+#endif
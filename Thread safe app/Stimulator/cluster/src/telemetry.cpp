@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "telemetry.h"
+
+double Telemetry::inertia(
+	int k, int d, const double* centroids, const double* sums, const double* counts, double squares
+) const
+{
+	// Moving each centroid to the mean of its members reduces their squared distances by count * |mean - centroid|².
+	double inertia = residual + squares;
+
+	for (int i = 0; i < k; i++)
+	{
+		if (counts[i] == 0)
+			continue;
+
+		double norm = 0;
+		for (int j = 0; j < d; j++)
+		{
+			double diff = sums[i * d + j] / counts[i] - centroids[i * d + j];
+			norm += diff * diff;
+		}
+
+		inertia -= counts[i] * norm;
+	}
+
+	return inertia;
+}
+
+void Telemetry::record(const IterationStats& stats)
+{
+	char line[256];
+	int length = snprintf(
+		line, sizeof(line),
+		"{\"rank\":%d,\"restart\":%d,\"iteration\":%d,\"inertia\":%.9g,\"changed\":%.0f,\"maxShift\":%.9g,\"ns\":%ld,"
+		"\"bytesSent\":%ld,\"bytesReceived\":%ld}\n",
+		stats.rank, stats.restart, stats.iteration, stats.inertia, stats.changed, stats.maxShift, stats.ns,
+		stats.bytesSent, stats.bytesReceived
+	);
+
+	lines.append(line, std::min(length, (int)sizeof(line) - 1));
+}
+
+void Telemetry::recordPartition(
+	int restart, int iteration, const std::vector<double>& weights, const std::vector<int>& counts
+)
+{
+	char element[64];
+	int length = snprintf(element, sizeof(element), "{\"restart\":%d,\"iteration\":%d", restart, iteration);
+	lines.append(element, length);
+
+	lines.append(",\"weights\":[");
+	for (size_t i = 0; i < weights.size(); i++)
+	{
+		length = snprintf(element, sizeof(element), i == 0 ? "%.6g" : ",%.6g", weights[i]);
+		lines.append(element, length);
+	}
+
+	lines.append("],\"counts\":[");
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		length = snprintf(element, sizeof(element), i == 0 ? "%d" : ",%d", counts[i]);
+		lines.append(element, length);
+	}
+
+	lines.append("]}\n");
+}
@@ -0,0 +1,158 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <string>
+#include <vector>
+
+#include "points.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+#endif
+
+/**
+ * Statistics of an iteration of k-means.
+ */
+struct IterationStats
+{
+	/**
+	 * Rank of the process that recorded the iteration (in `MPI_COMM_WORLD`); 0 unless distributed.
+	 */
+	int rank;
+
+	/**
+	 * Index of the restart the iteration belongs to.
+	 */
+	int restart;
+
+	/**
+	 * Number of the iteration within its restart, starting at 1.
+	 */
+	int iteration;
+
+	/**
+	 * Inertia of the memberships computed during the iteration, about the centroids computed from them.
+	 */
+	double inertia;
+
+	/**
+	 * Number of memberships that changed during the iteration.
+	 */
+	double changed;
+
+	/**
+	 * Largest (Euclidean) distance by which a centroid moved during the iteration.
+	 */
+	double maxShift;
+
+	/**
+	 * Wall time of the iteration, in nanoseconds.
+	 */
+	long ns;
+
+	/**
+	 * Bytes sent by the process during the iteration (see `Traffic`); 0 unless distributed.
+	 */
+	long bytesSent;
+
+	/**
+	 * Bytes received by the process during the iteration (see `Traffic`); 0 unless distributed.
+	 */
+	long bytesReceived;
+};
+
+#ifdef CLUSTER_MPI
+/**
+ * Bytes a process sent to & received from other processes by collective operations, counted as the payload of the
+ * buffers it passes & gets back (regardless of how the MPI implementation routes them), & only when a communicator
+ * holds other processes. Each method counts a call of the collective it's named after by this process.
+ */
+struct Traffic
+{
+	/**
+	 * Bytes sent to other processes.
+	 */
+	long sent = 0;
+
+	/**
+	 * Bytes received from other processes.
+	 */
+	long received = 0;
+
+	/**
+	 * Counts a reduction of `bytes` whose result every process of `comm` receives (or a scan).
+	 */
+	void allreduce(MPI_Comm comm, long bytes);
+
+	/**
+	 * Counts a broadcast of `bytes` from the `root` of `comm`.
+	 */
+	void broadcast(MPI_Comm comm, int root, long bytes);
+
+	/**
+	 * Counts a gather of `bytes` from every process of `comm` to every process.
+	 */
+	void allgather(MPI_Comm comm, long bytes);
+
+	/**
+	 * Counts a gather of `counts[p]` elements of `size` bytes from each process `p` of `comm` to every process.
+	 */
+	void allgatherv(MPI_Comm comm, const int* counts, long size);
+
+	/**
+	 * Counts an exchange of `sendCounts[p]` elements of `size` bytes sent to & `receiveCounts[p]` received from each
+	 * process `p` of `comm`, other than this one.
+	 */
+	void alltoallv(MPI_Comm comm, const int* sendCounts, const int* receiveCounts, long size);
+};
+#endif
+
+/**
+ * Collects the statistics of each iteration of k-means as lines of JSON. Lines are buffered in memory rather than
+ * written as they're recorded, such that recording costs no I/O (nor synchronization across threads or processes)
+ * while clustering.
+ */
+struct Telemetry
+{
+	/**
+	 * Inertia not accounted for by the points being clustered, i.e. that lost to bins when aggregating (see
+	 * `Aggregate::residual`), which `inertia` adds.
+	 */
+	double residual = 0;
+
+	/**
+	 * Recorded statistics, one line of JSON per iteration.
+	 */
+	std::string lines;
+
+	/**
+	 * Returns the inertia of the points being clustered about the means of their clusters, given the `squares`, `sums`
+	 * & `counts` accumulated by `assignAndAccumulate` while assigning them to the `k` `centroids` of `d` dimensions.
+	 * Derived as the sum of squared distances to the assigned centroids less count * |mean - centroid|² per cluster,
+	 * rather than by another pass over the points.
+	 */
+	double inertia(
+		int k, int d, const double* centroids, const double* sums, const double* counts, double squares
+	) const;
+
+	/**
+	 * Appends `stats` as a line of JSON.
+	 */
+	void record(const IterationStats& stats);
+
+	/**
+	 * Appends the share of points (`weights`) & number of points (`counts`) of each process, as repartitioned after
+	 * `iteration` of `restart` (see `balancePartition`), as a line of JSON.
+	 */
+	void recordPartition(int restart, int iteration, const std::vector<double>& weights, const std::vector<int>& counts);
+};
+
+#ifdef CLUSTER_MPI
+/**
+ * Appends the lines of the `telemetry` of every other process of `comm` to that of the root of `comm`, in order of
+ * rank. Must be called by every process of `comm`.
+ */
+void gatherTelemetry(Telemetry& telemetry, MPI_Comm comm);
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+#ifdef CLUSTER_MPI
+
+#include <vector>
+
+#include "telemetry.h"
+
+void Traffic::allreduce(MPI_Comm comm, long bytes)
+{
+	int size;
+	MPI_Comm_size(comm, &size);
+
+	if (size > 1)
+	{
+		sent += bytes;
+		received += bytes;
+	}
+}
+
+void Traffic::broadcast(MPI_Comm comm, int root, long bytes)
+{
+	int rank;
+	int size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	if (size > 1)
+		(rank == root ? sent : received) += bytes;
+}
+
+void Traffic::allgather(MPI_Comm comm, long bytes)
+{
+	int size;
+	MPI_Comm_size(comm, &size);
+
+	sent += size > 1 ? bytes : 0;
+	received += (size - 1) * bytes;
+}
+
+void Traffic::allgatherv(MPI_Comm comm, const int* counts, long size)
+{
+	int rank;
+	int processes;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &processes);
+
+	for (int p = 0; p < processes; p++)
+	{
+		if (p != rank)
+			received += counts[p] * size;
+	}
+
+	sent += processes > 1 ? counts[rank] * size : 0;
+}
+
+void Traffic::alltoallv(MPI_Comm comm, const int* sendCounts, const int* receiveCounts, long size)
+{
+	int rank;
+	int processes;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &processes);
+
+	for (int p = 0; p < processes; p++)
+	{
+		if (p != rank)
+		{
+			sent += sendCounts[p] * size;
+			received += receiveCounts[p] * size;
+		}
+	}
+}
+
+void gatherTelemetry(Telemetry& telemetry, MPI_Comm comm)
+{
+	int rank;
+	int size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	int length = (int)telemetry.lines.size();
+	std::vector<int> lengths(rank == 0 ? size : 0);
+	MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+
+	std::vector<int> displacements(lengths.size());
+	std::vector<char> lines;
+
+	if (rank == 0)
+	{
+		int total = 0;
+		for (int i = 0; i < size; i++)
+		{
+			displacements[i] = total;
+			total += lengths[i];
+		}
+
+		lines.resize(total);
+	}
+
+	MPI_Gatherv(
+		telemetry.lines.data(), length, MPI_CHAR,
+		lines.data(), lengths.data(), displacements.data(), MPI_CHAR,
+		0, comm
+	);
+
+	if (rank == 0)
+		telemetry.lines.assign(lines.begin(), lines.end());
+}
+
+#endif
@@ -0,0 +1,5 @@
+#include "timings.h"
+
+const char* PHASE_NAMES[PHASE_COUNT] = {
+	"load", "scatter", "aggregate", "seed", "assign", "reduce", "gather", "score", "write"
+};
@@ -0,0 +1,111 @@
+#ifndef TIMINGS_H
+#define TIMINGS_H
+
+#include <chrono>
+
+/**
+ * Clock with which the phases of clustering are timed.
+ */
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Phases of clustering that are timed separately.
+ */
+enum class Phase
+{
+	/**
+	 * Reading values from the input file.
+	 */
+	Load,
+
+	/**
+	 * Distributing values across nodes.
+	 */
+	Scatter,
+
+	/**
+	 * Collapsing values into weighted values, and expanding memberships back to every value.
+	 */
+	Aggregate,
+
+	/**
+	 * Choosing initial centroids.
+	 */
+	Seed,
+
+	/**
+	 * Assigning values to their closest centroid, and accumulating the members of each centroid.
+	 */
+	Assign,
+
+	/**
+	 * Combining accumulated members across nodes, and recomputing centroids.
+	 */
+	Reduce,
+
+	/**
+	 * Collecting memberships and the best run on the root node.
+	 */
+	Gather,
+
+	/**
+	 * Scoring the quality of the best run's clusters.
+	 */
+	Score,
+
+	/**
+	 * Writing memberships and centroids to output files.
+	 */
+	Write,
+};
+
+/**
+ * Number of `Phase`s.
+ */
+const int PHASE_COUNT = 9;
+
+/**
+ * Names of each `Phase`, as written to timing outputs.
+ */
+extern const char* PHASE_NAMES[PHASE_COUNT];
+
+/**
+ * Time spent in each `Phase` of clustering, in nanoseconds. Phases repeated across iterations (or restarts) are summed;
+ * when restarts run concurrently on several threads, so are their timings (i.e. phases report CPU time).
+ */
+struct Timings
+{
+	/**
+	 * Nanoseconds spent in each phase, indexed by `Phase`.
+	 */
+	long ns[PHASE_COUNT] = {};
+
+	/**
+	 * Returns the nanoseconds spent in `phase`.
+	 */
+	long& operator[](Phase phase)
+	{
+		return ns[(int)phase];
+	}
+
+	/**
+	 * Adds the time elapsed since `start` to `phase`, returning the current time; i.e. the start of the next phase.
+	 */
+	Clock::time_point lap(Phase phase, Clock::time_point start)
+	{
+		Clock::time_point now = Clock::now();
+		(*this)[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+		return now;
+	}
+
+	/**
+	 * Adds the time spent in each phase of `other`.
+	 */
+	void add(const Timings& other)
+	{
+		for (int i = 0; i < PHASE_COUNT; i++)
+			ns[i] += other.ns[i];
+	}
+};
+
+#endif
@@ -0,0 +1,22 @@
+#include <iostream>
+#include <algorithm>
+
+#include "util.h"
+
+void partition(int n, int size, int* counts, int* displacements)
+{
+	int maxElementsPerProcess = (n + size - 1) / size;
+	int r = n;
+
+	for (int i = 0; i < size; i++)
+	{
+		counts[i] = std::min(r, maxElementsPerProcess);
+		r -= counts[i];
+		displacements[i] = (i == 0) ? 0 : displacements[i - 1] + counts[i - 1];
+	}
+}
+
+bool hasConverged(int iterations, double changed, double shift, double tolerance, int maxIterations)
+{
+	return changed == 0 || shift <= tolerance || (maxIterations > 0 && iterations >= maxIterations);
+}
@@ -1,20 +1,6 @@
 #ifndef UTIL_H
 #define UTIL_H
 
-/**
- * Returns whether the arrays `l` and `r`, each of length `n` are identical.
- */
-template<typename T>
-bool arraysEqual(int n, T* l, T* r)
-{
-	for (int i = 0; i < n; i++)
-	{
-		if (l[i] != r[i])
-			return false;
-	}
-	return true;
-}
-
 /**
  * Prints the array `arr` of `n` elements to `std::cout` with `start` and `end` on either side, and each element
  * delimited by `separator`.
@@ -37,4 +23,17 @@ void printArr(int n, T* arr, const char* separator = ", ", const char* start = "
 		std::cout << end;
 }
 
+/**
+ * Partitions `n` elements across `size` processes into `counts` and `displacements` (both of length `size`), giving each
+ * process up to `ceil(n / size)` consecutive elements.
+ */
+void partition(int n, int size, int* counts, int* displacements);
+
+/**
+ * Returns whether k-means has converged after `iterations` iterations, the last of which changed `changed` memberships
+ * and shifted centroids by `shift` (relative to their magnitude); i.e. once no memberships change, centroids shift by
+ * no more than `tolerance`, or `maxIterations` (if positive) were executed.
+ */
+bool hasConverged(int iterations, double changed, double shift, double tolerance, int maxIterations);
+
 #endif
@@ -0,0 +1,175 @@
+#include <iostream>
+#include <charconv>
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+
+#include "warmstart.h"
+#include "loader.h"
+
+void ClusterState::fold(double* sums, double* counts) const
+{
+	for (int c = 0; c < k; c++)
+	{
+		counts[c] += this->counts[c];
+		for (int j = 0; j < d; j++)
+			sums[c * d + j] += this->counts[c] * centroids[c * d + j];
+	}
+}
+
+double ClusterState::squaredDistances(const double* centroids) const
+{
+	double sum = inertia;
+
+	for (int c = 0; c < k; c++)
+	{
+		if (counts[c] == 0)
+			continue;
+
+		double norm = 0;
+		for (int j = 0; j < d; j++)
+		{
+			double diff = this->centroids[c * d + j] - centroids[c * d + j];
+			norm += diff * diff;
+		}
+
+		sum += counts[c] * norm;
+	}
+
+	return sum;
+}
+
+void ClusterState::add(const Points& points, const int* memberships, const double* centroids, double inertia)
+{
+	this->inertia = squaredDistances(centroids) + inertia;
+
+	for (int i = 0; i < points.n; i++)
+		counts[memberships[i]] += points.weight(i);
+
+	this->centroids.assign(centroids, centroids + k * d);
+	n += points.n;
+}
+
+bool loadCentroids(const char* path, int k, int d, std::vector<double>& centroids)
+{
+	Dataset dataset;
+	if (!loadPoints(path, dataset, 1))
+		return false;
+
+	if (dataset.n != k || dataset.d != d)
+	{
+		std::cerr << path << ": Expected " << k << " centroids of " << d << " dimensions, but found " << dataset.n
+			<< " of " << dataset.d << '.' << std::endl;
+		return false;
+	}
+
+	// Input files store points as a structure of arrays, while centroids are stored consecutively.
+	Points points = dataset.points();
+	centroids.resize((size_t)k * d);
+
+	for (int j = 0; j < d; j++)
+	{
+		const double* dim = points.dim(j);
+		for (int c = 0; c < k; c++)
+			centroids[c * d + j] = dim[c];
+	}
+
+	return true;
+}
+
+int loadState(const char* path, ClusterState& state)
+{
+	std::ifstream f(path);
+	if (!f.is_open())
+	{
+		if (errno == ENOENT)
+			return 0;
+
+		std::cerr << "Failed to open " << path << " for reading the state of clusters" << std::endl;
+		return -1;
+	}
+
+	std::string line;
+	bool isValid = std::getline(f, line) && (std::istringstream(line) >> state.n >> state.inertia) && state.n >= 0;
+
+	state.k = 0;
+	state.counts.clear();
+	state.centroids.clear();
+
+	while (isValid && std::getline(f, line))
+	{
+		if (line.empty())
+			continue;
+
+		std::istringstream ss(line);
+		double count;
+		isValid = (bool)(ss >> count) && count >= 0;
+		state.counts.push_back(count);
+
+		for (int j = 0; isValid && j < state.d; j++)
+		{
+			double coordinate;
+			isValid = (bool)(ss >> coordinate);
+			state.centroids.push_back(coordinate);
+		}
+
+		double extra;
+		isValid = isValid && !(ss >> extra);
+		++state.k;
+	}
+
+	if (!isValid || state.k == 0)
+	{
+		std::cerr << path << ": Malformed state of clusters; expected a line holding the number of values & their "
+			<< "inertia, then a line per cluster holding its count & centroid of " << state.d << " dimensions."
+			<< std::endl;
+		return -1;
+	}
+
+	return 1;
+}
+
+bool writeState(const char* path, const ClusterState& state)
+{
+	FILE* f = fopen(path, "wb");
+	if (f == nullptr)
+	{
+		std::cerr << "Failed to open " << path << " for writing the state of clusters" << std::endl;
+		return false;
+	}
+
+	// Numbers are formatted in their shortest form that parses back to the same value.
+	std::vector<char> buffer(32 * ((size_t)state.d + 2) + 1);
+	char* c = buffer.data();
+	char* end = buffer.data() + buffer.size();
+
+	c = std::to_chars(c, end, state.n).ptr;
+	*c++ = ' ';
+	c = std::to_chars(c, end, state.inertia).ptr;
+	*c++ = '\n';
+	fwrite(buffer.data(), 1, c - buffer.data(), f);
+
+	for (int i = 0; i < state.k; i++)
+	{
+		c = std::to_chars(buffer.data(), end, state.counts[i]).ptr;
+		for (int j = 0; j < state.d; j++)
+		{
+			*c++ = ' ';
+			c = std::to_chars(c, end, state.centroids[i * state.d + j]).ptr;
+		}
+
+		*c++ = '\n';
+		fwrite(buffer.data(), 1, c - buffer.data(), f);
+	}
+
+	bool written = (ferror(f) == 0);
+	if (fclose(f) != 0 || !written)
+	{
+		std::cerr << "Failed to write the state of clusters to " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,100 @@
+#ifndef WARMSTART_H
+#define WARMSTART_H
+
+#include <vector>
+
+#include "points.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+#endif
+
+/**
+ * Clusters of every value clustered by previous runs in incremental mode (see `Args::stateFile`): the count & centroid
+ * of each, from which their sums are derived. Values are folded into the state in the order of the input file, such
+ * that a run only clusters the values appended since the previous run, with the memberships of earlier values frozen.
+ */
+struct ClusterState
+{
+	/**
+	 * Number of clusters.
+	 */
+	int k = 0;
+
+	/**
+	 * Number of dimensions of each value.
+	 */
+	int d = 1;
+
+	/**
+	 * Number of values folded into the state, i.e. the first `n` values of the input file.
+	 */
+	long n = 0;
+
+	/**
+	 * Inertia of the values folded into the state about the centroids of their clusters.
+	 */
+	double inertia = 0;
+
+	/**
+	 * Number (i.e. total weight) of the members of each cluster.
+	 */
+	std::vector<double> counts;
+
+	/**
+	 * Centroid of each cluster; `d` consecutive values per centroid. The mean of its members, unless it has none.
+	 */
+	std::vector<double> centroids;
+
+	/**
+	 * Adds the sums & counts of the members of each cluster to the running `sums` and `counts` of
+	 * `assignAndAccumulate`, such that centroids updated from them are the means of both previous & current members.
+	 */
+	void fold(double* sums, double* counts) const;
+
+	/**
+	 * Returns the sum of the squared distances between the values folded into the state & the given `centroids` of
+	 * their clusters, derived from their `inertia` about their own centroids.
+	 */
+	double squaredDistances(const double* centroids) const;
+
+	/**
+	 * Folds `points` into the state, given their `memberships` among the (updated) `centroids` of each cluster & their
+	 * `inertia` about them.
+	 */
+	void add(const Points& points, const int* memberships, const double* centroids, double inertia);
+};
+
+/**
+ * Reads `k` centroids of `d` dimensions each into `centroids` (`d` consecutive values per centroid) from the file at
+ * `path`, in either format written by `writeCentroids` (i.e. any input file of `k` points).
+ *
+ * Returns whether the file was read & holds `k` centroids of `d` dimensions; writes the reason to `std::cerr`
+ * otherwise.
+ */
+bool loadCentroids(const char* path, int k, int d, std::vector<double>& centroids);
+
+#ifdef CLUSTER_MPI
+/**
+ * Reads centroids like `loadCentroids` at the root of `comm`, & broadcasts them to every other process of `comm`.
+ * Returns the same at every process. Must be called by every process of `comm`.
+ */
+bool loadCentroidsParallel(const char* path, MPI_Comm comm, int k, int d, std::vector<double>& centroids);
+#endif
+
+/**
+ * Reads the state written by `writeState` from the file at `path` into `state`, whose `d` must be set. Returns 1 if
+ * read, 0 if there's no such file (leaving `state` empty), or -1 if it's malformed or of other dimensions (writing the
+ * reason to `std::cerr`).
+ */
+int loadState(const char* path, ClusterState& state);
+
+/**
+ * Writes `state` to the file at `path`, as a line holding the number of values & their inertia, followed by a
+ * line per cluster holding its count & the coordinates of its centroid (delimited by spaces).
+ *
+ * Returns whether the file was written; writes the reason to `std::cerr` otherwise.
+ */
+bool writeState(const char* path, const ClusterState& state);
+
+#endif
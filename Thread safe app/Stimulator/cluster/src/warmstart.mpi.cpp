@@ -0,0 +1,20 @@
+#ifdef CLUSTER_MPI
+
+#include "warmstart.h"
+
+bool loadCentroidsParallel(const char* path, MPI_Comm comm, int k, int d, std::vector<double>& centroids)
+{
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+
+	int loaded = (rank == 0) && loadCentroids(path, k, d, centroids);
+	MPI_Bcast(&loaded, 1, MPI_INT, 0, comm);
+	if (!loaded)
+		return false;
+
+	centroids.resize((size_t)k * d);
+	MPI_Bcast(centroids.data(), k * d, MPI_DOUBLE, 0, comm);
+	return true;
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "writer.h"
+#include "loader.h"
+
+static_assert(sizeof(int) == sizeof(int32_t), "Binary memberships are written as they're stored.");
+
+/**
+ * Maximum number of characters of a membership formatted as text, including its sign & newline.
+ */
+const int MAX_MEMBERSHIP_CHARS = 12;
+
+/**
+ * Minimum number of memberships formatted by each thread of `writeMemberships`.
+ */
+const int MIN_CHUNK_MEMBERSHIPS = 1 << 16;
+
+void formatMemberships(int n, const int* memberships, OutputFormat format, std::vector<char>& buffer)
+{
+	size_t size = buffer.size();
+
+	if (format == OutputFormat::Binary)
+	{
+		buffer.resize(size + sizeof(int32_t) * n);
+		memcpy(buffer.data() + size, memberships, sizeof(int32_t) * n);
+		return;
+	}
+
+	buffer.resize(size + (size_t)MAX_MEMBERSHIP_CHARS * n);
+
+	char* c = buffer.data() + size;
+	char* end = buffer.data() + buffer.size();
+
+	for (int i = 0; i < n; i++)
+	{
+		c = std::to_chars(c, end, memberships[i]).ptr;
+		*c++ = '\n';
+	}
+
+	buffer.resize(c - buffer.data());
+}
+
+bool writeMemberships(const char* path, int n, const int* memberships, OutputFormat format, int threads)
+{
+	FILE* f = fopen(path, "wb");
+	if (f == nullptr)
+	{
+		std::cerr << "Failed to open " << path << " for writing memberships" << std::endl;
+		return false;
+	}
+
+	if (format == OutputFormat::Binary)
+	{
+		fwrite(memberships, sizeof(int32_t), n, f);
+	}
+	else
+	{
+		// Format chunks of memberships on their own thread, then write them in order.
+		if (threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = std::max(1, std::min(threads, n / MIN_CHUNK_MEMBERSHIPS));
+
+		std::vector<std::vector<char>> buffers(threads);
+		auto formatChunk = [&](int t)
+		{
+			int start = (int)((long)n * t / threads);
+			int end = (int)((long)n * (t + 1) / threads);
+			formatMemberships(end - start, memberships + start, format, buffers[t]);
+		};
+
+		std::vector<std::thread> workers;
+		for (int t = 1; t < threads; t++)
+			workers.emplace_back(formatChunk, t);
+		formatChunk(0);
+
+		for (int t = 0; t < threads; t++)
+		{
+			if (t > 0)
+				workers[t - 1].join();
+
+			fwrite(buffers[t].data(), 1, buffers[t].size(), f);
+		}
+	}
+
+	bool written = (ferror(f) == 0);
+	if (fclose(f) != 0 || !written)
+	{
+		std::cerr << "Failed to write memberships to " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool writeCentroids(const char* path, int k, int d, const double* centroids, OutputFormat format)
+{
+	FILE* f = fopen(path, "wb");
+	if (f == nullptr)
+	{
+		std::cerr << "Failed to open " << path << " for writing centroids" << std::endl;
+		return false;
+	}
+
+	if (format == OutputFormat::Binary)
+	{
+		BinaryHeader header = {};
+		memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+		header.d = d;
+		header.valueSize = sizeof(double);
+		header.n = k;
+		fwrite(&header, sizeof(header), 1, f);
+
+		// Binary input files store points as a structure of arrays.
+		std::vector<double> dim(k);
+		for (int j = 0; j < d; j++)
+		{
+			for (int i = 0; i < k; i++)
+				dim[i] = centroids[i * d + j];
+
+			fwrite(dim.data(), sizeof(double), k, f);
+		}
+	}
+	else
+	{
+		// Coordinates are formatted in their shortest form that parses back to the same value.
+		std::vector<char> buffer(32 * (size_t)d + 1);
+
+		for (int i = 0; i < k; i++)
+		{
+			char* c = buffer.data();
+			char* end = buffer.data() + buffer.size();
+
+			for (int j = 0; j < d; j++)
+			{
+				if (j != 0)
+					*c++ = ' ';
+				c = std::to_chars(c, end, centroids[i * d + j]).ptr;
+			}
+
+			*c++ = '\n';
+			fwrite(buffer.data(), 1, c - buffer.data(), f);
+		}
+	}
+
+	bool written = (ferror(f) == 0);
+	if (fclose(f) != 0 || !written)
+	{
+		std::cerr << "Failed to write centroids to " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,44 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <vector>
+
+#include "Args.h"
+
+#ifdef CLUSTER_MPI
+#include <mpich/mpi.h>
+#endif
+
+/**
+ * Appends the `n` `memberships` to `buffer` in `format`: as a line of text each, or as consecutive `int32_t`s.
+ */
+void formatMemberships(int n, const int* memberships, OutputFormat format, std::vector<char>& buffer);
+
+/**
+ * Writes the `n` `memberships` to the file at `path` in `format`. Text is formatted in chunks by up to `threads` threads
+ * (or one per hardware thread, if not positive), each into its own buffer, & the buffers written in order.
+ *
+ * Returns whether the file was written; writes the reason to `std::cerr` otherwise.
+ */
+bool writeMemberships(const char* path, int n, const int* memberships, OutputFormat format, int threads = 0);
+
+/**
+ * Writes the `k` `centroids` of `d` dimensions each (stored consecutively) to the file at `path` in `format`: as a line
+ * of text per centroid with coordinates delimited by spaces, or as a binary input file (see `BinaryHeader`).
+ *
+ * Returns whether the file was written; writes the reason to `std::cerr` otherwise.
+ */
+bool writeCentroids(const char* path, int k, int d, const double* centroids, OutputFormat format);
+
+#ifdef CLUSTER_MPI
+/**
+ * Writes memberships computed across the processes of `comm` to the file at `path` in `format`, with collective MPI-IO
+ * writes: each process writes its `n` `memberships` directly after those of the processes of lower rank, at an offset
+ * derived from the size of theirs. Must be called by every process of `comm`.
+ *
+ * Returns whether the file was written (by every process); the root writes the reason to `std::cerr` otherwise.
+ */
+bool writeMembershipsParallel(const char* path, MPI_Comm comm, int n, const int* memberships, OutputFormat format);
+#endif
+
+#endif
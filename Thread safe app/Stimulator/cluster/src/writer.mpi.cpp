@@ -0,0 +1,64 @@
+#ifdef CLUSTER_MPI
+
+#include <iostream>
+#include <algorithm>
+
+#include "writer.h"
+
+/**
+ * Maximum number of bytes written by each process per collective write; counts of MPI calls are `int`s.
+ */
+const long long MAX_WRITE_SIZE = 1 << 30;
+
+bool writeMembershipsParallel(const char* path, MPI_Comm comm, int n, const int* memberships, OutputFormat format)
+{
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+
+	// Format this process' memberships, & derive where they're written from the size of those of lower ranks.
+	std::vector<char> buffer;
+	formatMemberships(n, memberships, format, buffer);
+
+	long long size = buffer.size();
+	long long offset = 0;
+	long long maxSize = 0;
+	long long totalSize = 0;
+	MPI_Exscan(&size, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+	MPI_Allreduce(&size, &maxSize, 1, MPI_LONG_LONG, MPI_MAX, comm);
+	MPI_Allreduce(&size, &totalSize, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+	// The result of the scan is undefined at the root.
+	if (rank == 0)
+		offset = 0;
+
+	MPI_File f;
+	if (MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &f) != MPI_SUCCESS)
+	{
+		if (rank == 0)
+			std::cerr << "Failed to open " << path << " for writing memberships" << std::endl;
+		return false;
+	}
+
+	// Truncate previous contents of the file, & write in as many rounds as the largest slice takes; every process must
+	// take part in each.
+	int written = (MPI_File_set_size(f, totalSize) == MPI_SUCCESS);
+
+	for (long long start = 0; start < maxSize; start += MAX_WRITE_SIZE)
+	{
+		long long count = std::max(0LL, std::min(MAX_WRITE_SIZE, size - start));
+		const char* data = buffer.data() + std::min(start, size);
+
+		if (MPI_File_write_at_all(f, offset + start, data, (int)count, MPI_BYTE, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+			written = 0;
+	}
+
+	MPI_File_close(&f);
+
+	MPI_Allreduce(MPI_IN_PLACE, &written, 1, MPI_INT, MPI_MIN, comm);
+	if (!written && rank == 0)
+		std::cerr << "Failed to write memberships to " << path << std::endl;
+
+	return written;
+}
+
+#endif